@@ -8,6 +8,7 @@ Source0:    %{name}-%{version}.tar.bz2
 Requires:   connman >= 1.38
 Requires:   connman-qt5 >= 1.2.10
 BuildRequires:  pkgconfig(Qt5Core)
+BuildRequires:  pkgconfig(Qt5Gui)
 BuildRequires:  pkgconfig(Qt5Network)
 BuildRequires:  pkgconfig(Qt5Qml)
 BuildRequires:  pkgconfig(Qt5DBus)
@@ -28,7 +28,16 @@
  */
 
 #include "connectionhelper.h"
+#include "connectivitybackend_p.h"
+#include "connectivityprobe_p.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJSValue>
+#include <QPointer>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
 #include <QTimer>
 #include <QUrl>
 #include <QString>
@@ -40,6 +49,8 @@
 #include <QtDBus/QDBusPendingCall>
 #include <QtDBus/QDBusPendingCallWatcher>
 
+#include <limits>
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <connman-qt6/networkmanager.h>
 #include <connman-qt6/networktechnology.h>
@@ -50,38 +61,125 @@
 #include <connman-qt5/networkservice.h>
 #endif
 
+namespace {
+
+const int DefaultVerdictTimeToLive = 30000;
+
+const QString ConnectionSelectorService = QStringLiteral("com.jolla.lipstick.ConnectionSelector");
+const QString ConnectionSelectorPath = QStringLiteral("/");
+const QString ConnectionSelectorInterface = QStringLiteral("com.jolla.lipstick.ConnectionSelectorIf");
+
+// How an attempt got to its outcome, for the latency histograms.
+enum AttemptPath {
+    NoRoutePath,
+    AlreadyOnlinePath,
+    CachedVerdictPath,
+    ProbePath,
+    SelectorPath
+};
+
+QString attemptPathName(AttemptPath path)
+{
+    switch (path) {
+    case AlreadyOnlinePath:
+        return QStringLiteral("online");
+    case CachedVerdictPath:
+        return QStringLiteral("cached");
+    case ProbePath:
+        return QStringLiteral("probe");
+    case SelectorPath:
+        return QStringLiteral("selector");
+    default:
+        return QStringLiteral("noroute");
+    }
+}
+
+Nemo::ProbeParameters probeParameters(Nemo::ConnectivityPolicy *policy, const QStringList &fallbackUrls)
+{
+    Nemo::ProbeParameters parameters;
+    parameters.fallbackUrls = fallbackUrls;
+    parameters.method = policy->probeMethod();
+    parameters.expectedStatusCodes = policy->expectedStatusCodes();
+    parameters.expectedBody = policy->expectedBody().toUtf8();
+    return parameters;
+}
+
+}
+
 class ConnectionHelperPrivate
 {
 public:
     ConnectionHelperPrivate();
 
+    struct Job {
+        int id;
+        int priority;
+        qint64 deadline; // msecs since epoch, or 0 for none.
+        std::function<void()> run;
+    };
+
     QTimer m_timeoutTimer;
-    QNetworkAccessManager *m_networkAccessManager;
-    QString m_defaultNetworkStatusCheckUrl;
-    bool m_networkConfigReady;
-    bool m_delayedNetworkStatusCheckUrl;
+    QTimer m_stateDebounceTimer;
+    QElapsedTimer m_stateDebounceStarted;
+    QString m_pendingNetworkState;
+    QString m_appliedNetworkState;
+    QElapsedTimer m_attemptTimer;
+    AttemptPath m_attemptPath;
+    bool m_explicitAttempt;
+    Nemo::ConnectivityProbe *m_canaryProbe;
+    QStringList m_fallbackStatusCheckUrls;
+    int m_verdictTimeToLive;
+    int m_probeRetriesLeft;
+    Nemo::ConnectivityPolicy *m_defaultPolicy;
+    QPointer<Nemo::ConnectivityPolicy> m_policy;
     bool m_delayedAttemptToConnect;
     bool m_detectingNetworkConnection;
-    bool m_connmanIsAvailable;
     bool m_selectorVisible;
     Nemo::ConnectionHelper::Status m_status;
 
+    QSharedPointer<Nemo::ConnectivityBackend> m_backend;
     QSharedPointer<NetworkManager> m_netman;
 
-    QDBusInterface *m_connectionSelectorInterface;
+    bool m_connectionSelectorConnected;
+    bool m_connectionSelectorPrewarmed;
+
+    QList<Job> m_jobs; // by descending priority, then in order of arrival.
+    int m_nextJobId;
+    QTimer m_drainTimer;
+    QTimer m_jobExpiryTimer;
+
+    QTimer m_retryTimer;
+    int m_retryCount;
+
+    bool m_monitoring;
+    bool m_stallDetection;
+    bool m_linkWatching;
+    bool m_verifyingHandover;
+    QStringList m_warmUpHosts;
+    QList<QPointer<Nemo::NetworkRequirement>> m_requirements;
 };
 
 ConnectionHelperPrivate::ConnectionHelperPrivate()
-    : m_networkAccessManager(0)
-    , m_networkConfigReady(false)
-    , m_delayedNetworkStatusCheckUrl(false)
+    : m_attemptPath(NoRoutePath)
+    , m_explicitAttempt(false)
+    , m_canaryProbe(nullptr)
+    , m_verdictTimeToLive(DefaultVerdictTimeToLive)
+    , m_probeRetriesLeft(0)
+    , m_defaultPolicy(nullptr)
     , m_delayedAttemptToConnect(false)
     , m_detectingNetworkConnection(false)
-    , m_connmanIsAvailable(false)
     , m_selectorVisible(false)
     , m_status(Nemo::ConnectionHelper::Unknown)
-    , m_netman(NetworkManager::sharedInstance())
-    , m_connectionSelectorInterface(nullptr)
+    , m_backend(Nemo::ConnectivityBackend::sharedInstance())
+    , m_netman(m_backend->networkManager())
+    , m_connectionSelectorConnected(false)
+    , m_connectionSelectorPrewarmed(false)
+    , m_nextJobId(1)
+    , m_retryCount(0)
+    , m_monitoring(false)
+    , m_stallDetection(false)
+    , m_linkWatching(false)
+    , m_verifyingHandover(false)
 {
 }
 
@@ -94,11 +192,46 @@ ConnectionHelper::ConnectionHelper(QObject *parent)
     connect(&d_ptr->m_timeoutTimer, &QTimer::timeout,
             this, &ConnectionHelper::emitFailureIfNeeded);
     d_ptr->m_timeoutTimer.setSingleShot(true);
+    d_ptr->m_timeoutTimer.setTimerType(Qt::CoarseTimer);
+    connect(&d_ptr->m_stateDebounceTimer, &QTimer::timeout,
+            this, &ConnectionHelper::applyNetworkState);
+    d_ptr->m_stateDebounceTimer.setSingleShot(true);
+    d_ptr->m_stateDebounceTimer.setTimerType(Qt::CoarseTimer);
+    connect(&d_ptr->m_drainTimer, &QTimer::timeout,
+            this, &ConnectionHelper::drainJobs);
+    d_ptr->m_drainTimer.setSingleShot(true);
+    connect(&d_ptr->m_jobExpiryTimer, &QTimer::timeout,
+            this, &ConnectionHelper::expireJobs);
+    d_ptr->m_jobExpiryTimer.setSingleShot(true);
+    d_ptr->m_jobExpiryTimer.setTimerType(Qt::CoarseTimer);
+    connect(&d_ptr->m_retryTimer, &QTimer::timeout,
+            this, &ConnectionHelper::retryNetworkRequest);
+    d_ptr->m_retryTimer.setSingleShot(true);
+    d_ptr->m_retryTimer.setTimerType(Qt::CoarseTimer);
+
+    d_ptr->m_defaultPolicy = new ConnectivityPolicy(this);
+    connectPolicy();
 
-    connect(d_ptr->m_netman.data(), &NetworkManager::availabilityChanged,
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::readyChanged,
+            this, &ConnectionHelper::readyChanged);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::connmanAvailableChanged,
             this, &ConnectionHelper::connmanAvailableChanged);
-    connect(d_ptr->m_netman.data(), &NetworkManager::stateChanged,
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::networkStateChanged,
             this, &ConnectionHelper::networkStateChanged);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::linkQualityChanged,
+            this, &ConnectionHelper::linkQualityChanged);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::monitorVerdict,
+            this, &ConnectionHelper::handleMonitorVerdict);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::stallDetected,
+            this, &ConnectionHelper::handleStallDetected);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::linkLost,
+            this, &ConnectionHelper::handleLinkLost);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::addressLost,
+            this, &ConnectionHelper::handleAddressLost);
+    connect(d_ptr->m_backend.data(), &ConnectivityBackend::handover,
+            this, &ConnectionHelper::handleHandover);
+
+    d_ptr->m_appliedNetworkState = d_ptr->m_netman->state();
 
     if (d_ptr->m_netman->defaultRoute()) {
         if (d_ptr->m_netman->defaultRoute()->serviceState() == NetworkService::OnlineState) {
@@ -107,55 +240,34 @@ ConnectionHelper::ConnectionHelper(QObject *parent)
             updateStatus(ConnectionHelper::Connected);
         }
     }
-
-    d_ptr->m_connmanIsAvailable = QDBusConnection::systemBus().interface()->isServiceRegistered("net.connman");
-    if (d_ptr->m_connmanIsAvailable) {
-        determineDefaultNetworkStatusCheckUrl();
-    } else {
-        d_ptr->m_delayedNetworkStatusCheckUrl = true;
-    }
 }
 
 ConnectionHelper::~ConnectionHelper()
 {
+    if (d_ptr->m_monitoring) {
+        d_ptr->m_backend->removeMonitor(this);
+    }
+    if (d_ptr->m_stallDetection) {
+        d_ptr->m_backend->removeStallWatcher(this);
+    }
+    if (d_ptr->m_linkWatching) {
+        d_ptr->m_backend->removeLinkWatcher(this);
+    }
+    if (!d_ptr->m_warmUpHosts.isEmpty()) {
+        d_ptr->m_backend->setWarmUpHosts(this, QStringList());
+    }
+    releaseCanaryRequest();
     delete d_ptr;
 }
 
-void ConnectionHelper::determineDefaultNetworkStatusCheckUrl()
-{
-    d_ptr->m_delayedNetworkStatusCheckUrl = false;
-    QDBusConnection::systemBus().callWithCallback(
-            QDBusMessage::createMethodCall(QStringLiteral("net.connman"),
-                                           QStringLiteral("/"),
-                                           QStringLiteral("net.connman.Manager"),
-                                           QStringLiteral("GetProperties")),
-            this,
-            SLOT(getConnmanManagerProperties(QVariantMap)));
-}
-
-void ConnectionHelper::getConnmanManagerProperties(const QVariantMap &props)
+void ConnectionHelper::connmanAvailableChanged(bool available)
 {
-    d_ptr->m_defaultNetworkStatusCheckUrl = props.value(QStringLiteral("Ipv4StatusUrl")).toString();
-    if (d_ptr->m_delayedAttemptToConnect) {
+    if (available && d_ptr->m_delayedAttemptToConnect) {
         d_ptr->m_delayedAttemptToConnect = false;
         attemptToConnectNetwork();
     }
 }
 
-void ConnectionHelper::connmanAvailableChanged(bool available)
-{
-    if (available) {
-        d_ptr->m_networkConfigReady = true;
-        if (d_ptr->m_delayedNetworkStatusCheckUrl) {
-            determineDefaultNetworkStatusCheckUrl();
-        } else if (d_ptr->m_delayedAttemptToConnect) {
-            d_ptr->m_delayedAttemptToConnect = false;
-            attemptToConnectNetwork();
-        }
-    }
-    d_ptr->m_connmanIsAvailable = available;
-}
-
 bool ConnectionHelper::online() const
 {
     return d_ptr->m_status == ConnectionHelper::Online;
@@ -171,6 +283,414 @@ ConnectionHelper::Status ConnectionHelper::status() const
     return d_ptr->m_status;
 }
 
+/*
+    False while connman's presence is still being determined. Connection
+    attempts made before that are carried out once connman is available.
+*/
+bool ConnectionHelper::ready() const
+{
+    return d_ptr->m_backend->ready();
+}
+
+/*
+    Additional status check urls raced after the ones published by connman.
+    Each is requested with the policy's probeMethod, and counts as
+    reachable if the reply matches the policy's expected status codes and
+    body; a redirect or a 511 reply means a captive portal instead.
+*/
+QStringList ConnectionHelper::fallbackStatusUrls() const
+{
+    return d_ptr->m_fallbackStatusCheckUrls;
+}
+
+void ConnectionHelper::setFallbackStatusUrls(const QStringList &urls)
+{
+    if (d_ptr->m_fallbackStatusCheckUrls != urls) {
+        d_ptr->m_fallbackStatusCheckUrls = urls;
+        updateMonitor();
+        emit fallbackStatusUrlsChanged();
+    }
+}
+
+/*
+    How long, in milliseconds, a successful canary request is reused for
+    further requests while the default route and its state stay the same.
+    Failures are always probed again. Zero disables the reuse.
+*/
+int ConnectionHelper::verdictTimeToLive() const
+{
+    return d_ptr->m_verdictTimeToLive;
+}
+
+void ConnectionHelper::setVerdictTimeToLive(int timeToLive)
+{
+    if (d_ptr->m_verdictTimeToLive != timeToLive) {
+        d_ptr->m_verdictTimeToLive = timeToLive;
+        emit verdictTimeToLiveChanged();
+    }
+}
+
+/*
+    Timeouts and canary check used by this helper. Unless set, the helper
+    uses a policy of its own with the default values, which can also be
+    adjusted in place.
+*/
+ConnectivityPolicy *ConnectionHelper::policy() const
+{
+    return d_ptr->m_policy ? d_ptr->m_policy.data() : d_ptr->m_defaultPolicy;
+}
+
+void ConnectionHelper::setPolicy(ConnectivityPolicy *policy)
+{
+    if (d_ptr->m_policy != policy) {
+        disconnect(this->policy(), nullptr, this, nullptr);
+        d_ptr->m_policy = policy;
+        connectPolicy();
+        updateMonitor();
+        emit policyChanged();
+    }
+}
+
+/*
+    Whether connectivity is re-verified in the background while connected.
+    The checks back off while the network stays online and come sooner
+    after a failure or a change of route, so that e.g. a connection that
+    went dead behind a captive portal drops from Online to Connected, and
+    back once it works again. The checks follow the policy's canary check
+    and the fallback urls. Disabled by default.
+*/
+bool ConnectionHelper::monitoring() const
+{
+    return d_ptr->m_monitoring;
+}
+
+void ConnectionHelper::setMonitoring(bool monitoring)
+{
+    if (d_ptr->m_monitoring != monitoring) {
+        d_ptr->m_monitoring = monitoring;
+        if (monitoring) {
+            updateMonitor();
+        } else {
+            d_ptr->m_backend->removeMonitor(this);
+        }
+        emit monitoringChanged();
+    }
+}
+
+/*
+    Whether the default route is watched for stalls without sending any
+    traffic of its own: packets keep going out on its interface but none
+    come back. A stall drops the status from Online to Connected and only
+    then triggers a canary check, which restores Online if the network
+    turns out to work. Disabled by default.
+*/
+bool ConnectionHelper::stallDetection() const
+{
+    return d_ptr->m_stallDetection;
+}
+
+void ConnectionHelper::setStallDetection(bool stallDetection)
+{
+    if (d_ptr->m_stallDetection != stallDetection) {
+        d_ptr->m_stallDetection = stallDetection;
+        if (stallDetection) {
+            updateMonitor();
+        } else {
+            d_ptr->m_backend->removeStallWatcher(this);
+        }
+        emit stallDetectionChanged();
+    }
+}
+
+/*
+    Whether carrier and address loss on the default route's interface are
+    picked up from the kernel directly, ahead of connman. Losing the carrier
+    makes the helper Offline and losing the last usable address drops it
+    from Online to Connected at once; a canary check restores Online if the
+    link comes back before connman has noticed anything. Disabled by
+    default.
+*/
+bool ConnectionHelper::linkWatching() const
+{
+    return d_ptr->m_linkWatching;
+}
+
+void ConnectionHelper::setLinkWatching(bool linkWatching)
+{
+    if (d_ptr->m_linkWatching != linkWatching) {
+        d_ptr->m_linkWatching = linkWatching;
+        if (linkWatching) {
+            updateMonitor();
+        } else {
+            d_ptr->m_backend->removeLinkWatcher(this);
+        }
+        emit linkWatchingChanged();
+    }
+}
+
+/*
+    Host names resolved in parallel as soon as a route becomes usable, so
+    that they are in the resolver caches by the time they are needed.
+    The lists of all helpers are combined.
+*/
+QStringList ConnectionHelper::warmUpHosts() const
+{
+    return d_ptr->m_warmUpHosts;
+}
+
+void ConnectionHelper::setWarmUpHosts(const QStringList &hosts)
+{
+    if (d_ptr->m_warmUpHosts != hosts) {
+        d_ptr->m_warmUpHosts = hosts;
+        d_ptr->m_backend->setWarmUpHosts(this, hosts);
+        emit warmUpHostsChanged();
+    }
+}
+
+/*
+    Host name lookup times by network interface, from warm-ups and canary
+    requests, along with the number of failed warm-up lookups.
+*/
+QVariantMap ConnectionHelper::resolverStatistics() const
+{
+    QVariantMap statistics;
+    const QMap<QString, ResolverStatistics> resolvers = d_ptr->m_backend->resolverStatistics();
+    for (auto it = resolvers.constBegin(); it != resolvers.constEnd(); ++it) {
+        QVariantMap entry = it.value().latency.toVariantMap();
+        entry.insert(QStringLiteral("failures"), it.value().failures);
+        statistics.insert(it.key(), entry);
+    }
+    return statistics;
+}
+
+/*
+    Reports through requirementAvailable() and requirementLost() when a
+    network meeting the requirement comes and goes. If one is already
+    there, requirementAvailable() follows right away.
+*/
+void ConnectionHelper::addRequirement(NetworkRequirement *requirement)
+{
+    if (!requirement || d_ptr->m_requirements.contains(requirement)) {
+        return;
+    }
+
+    d_ptr->m_requirements.append(requirement);
+    connect(requirement, &NetworkRequirement::available, this, [this, requirement] {
+        emit requirementAvailable(requirement);
+    });
+    connect(requirement, &NetworkRequirement::lost, this, [this, requirement] {
+        emit requirementLost(requirement);
+    });
+
+    if (requirement->satisfied()) {
+        QPointer<NetworkRequirement> guard(requirement);
+        QTimer::singleShot(0, this, [this, guard] {
+            if (guard && guard->satisfied() && d_ptr->m_requirements.contains(guard)) {
+                emit requirementAvailable(guard);
+            }
+        });
+    }
+}
+
+void ConnectionHelper::removeRequirement(NetworkRequirement *requirement)
+{
+    if (requirement && d_ptr->m_requirements.removeAll(requirement) > 0) {
+        disconnect(requirement, nullptr, this, nullptr);
+    }
+}
+
+void ConnectionHelper::handleLinkLost()
+{
+    if (!d_ptr->m_linkWatching) {
+        return;
+    }
+
+    if (d_ptr->m_detectingNetworkConnection) {
+        // no point in waiting for the timeout.
+        emitFailureIfNeeded();
+    } else if (d_ptr->m_status == ConnectionHelper::Online
+               || d_ptr->m_status == ConnectionHelper::Connected) {
+        handleNetworkUnavailable();
+    }
+}
+
+/*
+    The default route moved from one usable service to another, e.g. from
+    WLAN to cellular, possibly without the state ever leaving online.
+    Connections bound to the previous interface are best re-established
+    right away. previous and current hold the "service" path, "name",
+    "technology" and "interface" of the routes. An Online helper verifies
+    the new route at once and drops to Connected if it does not work.
+*/
+void ConnectionHelper::handleHandover(const QVariantMap &previous, const QVariantMap &current)
+{
+    if (d_ptr->m_status == ConnectionHelper::Online && !d_ptr->m_detectingNetworkConnection) {
+        d_ptr->m_verifyingHandover = d_ptr->m_backend->verify(
+                    probeParameters(policy(), d_ptr->m_fallbackStatusCheckUrls));
+    }
+    emit handover(previous, current);
+}
+
+void ConnectionHelper::handleAddressLost()
+{
+    if (d_ptr->m_linkWatching && !d_ptr->m_detectingNetworkConnection
+            && d_ptr->m_status == ConnectionHelper::Online) {
+        updateStatus(ConnectionHelper::Connected);
+    }
+}
+
+/*
+    Background checks keep their probe parameters with the backend, so
+    changes to the canary check of the policy in use are passed on.
+*/
+void ConnectionHelper::connectPolicy()
+{
+    ConnectivityPolicy *current = policy();
+    connect(current, &ConnectivityPolicy::probeMethodChanged, this, &ConnectionHelper::updateMonitor);
+    connect(current, &ConnectivityPolicy::expectedStatusCodesChanged, this, &ConnectionHelper::updateMonitor);
+    connect(current, &ConnectivityPolicy::expectedBodyChanged, this, &ConnectionHelper::updateMonitor);
+    connect(current, &ConnectivityPolicy::probeRetriesChanged, this, &ConnectionHelper::updateMonitor);
+
+    if (current != d_ptr->m_defaultPolicy) {
+        // Falls back to the default policy once the assigned one is gone.
+        connect(current, &QObject::destroyed, this, [this]() {
+            connectPolicy();
+            updateMonitor();
+            emit policyChanged();
+        });
+    }
+}
+
+void ConnectionHelper::updateMonitor()
+{
+    const ProbeParameters parameters = probeParameters(policy(), d_ptr->m_fallbackStatusCheckUrls);
+    if (d_ptr->m_monitoring) {
+        d_ptr->m_backend->addMonitor(this, parameters);
+    }
+    if (d_ptr->m_stallDetection) {
+        d_ptr->m_backend->addStallWatcher(this, parameters);
+    }
+    if (d_ptr->m_linkWatching) {
+        d_ptr->m_backend->addLinkWatcher(this, parameters);
+    }
+}
+
+void ConnectionHelper::handleStallDetected()
+{
+    if (d_ptr->m_stallDetection && !d_ptr->m_detectingNetworkConnection
+            && d_ptr->m_status == ConnectionHelper::Online) {
+        updateStatus(ConnectionHelper::Connected);
+    }
+}
+
+void ConnectionHelper::handleMonitorVerdict(bool online)
+{
+    const bool verifyingHandover = d_ptr->m_verifyingHandover;
+    d_ptr->m_verifyingHandover = false;
+    if (!(verifyingHandover || d_ptr->m_monitoring || d_ptr->m_stallDetection || d_ptr->m_linkWatching)
+            || d_ptr->m_detectingNetworkConnection) {
+        return;
+    }
+
+    if (!online && d_ptr->m_status == ConnectionHelper::Online) {
+        updateStatus(ConnectionHelper::Connected);
+    } else if (online && (d_ptr->m_status == ConnectionHelper::Connected
+                          || (d_ptr->m_linkWatching && d_ptr->m_status == ConnectionHelper::Offline))) {
+        // Offline only when the link watcher got there before connman.
+        handleNetworkEstablished();
+    }
+}
+
+/*
+    Round-trip time and jitter estimated from the canary requests made on
+    the current default route, shared by all helpers in the process.
+    rtt and jitter are -1 until the first measurement.
+*/
+LinkQuality ConnectionHelper::linkQuality() const
+{
+    return d_ptr->m_backend->linkQuality();
+}
+
+int ConnectionHelper::rtt() const
+{
+    return d_ptr->m_backend->linkQuality().rtt;
+}
+
+int ConnectionHelper::jitter() const
+{
+    return d_ptr->m_backend->linkQuality().jitter;
+}
+
+/*
+    Estimated downstream bandwidth of the default route in kbit/s, from
+    large downloads through the shared network access manager, or -1.
+*/
+int ConnectionHelper::bandwidth() const
+{
+    return d_ptr->m_backend->linkQuality().bandwidth;
+}
+
+QVariantMap ConnectionHelper::lastProbeTiming() const
+{
+    return d_ptr->m_backend->linkQuality().lastProbe.toVariantMap();
+}
+
+/*
+    Time from attemptToConnectNetwork() or requestNetwork() to
+    networkConnectivityEstablished() or networkConnectivityUnavailable(),
+    collected over all helpers in the process. Keys are of the form
+    "<explicit|implicit>/<path>/<established|unavailable>", where path is
+    "online" when connman already was, "cached" for a reused canary
+    verdict, "probe" for a canary request, "selector" when the connection
+    selector was shown and "noroute" otherwise.
+*/
+QMap<QString, LatencyHistogram> ConnectionHelper::latencyHistograms() const
+{
+    return d_ptr->m_backend->latencyHistograms();
+}
+
+QVariantMap ConnectionHelper::latencyStatistics() const
+{
+    QVariantMap statistics;
+    const QMap<QString, LatencyHistogram> histograms = latencyHistograms();
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it) {
+        statistics.insert(it.key(), it.value().toVariantMap());
+    }
+    return statistics;
+}
+
+QString ConnectionHelper::dumpLatencyStatistics() const
+{
+    QStringList lines;
+    const QMap<QString, LatencyHistogram> histograms = latencyHistograms();
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it) {
+        lines.append(it.key() + QStringLiteral(": ") + it.value().toString());
+    }
+
+    const QString dump = lines.join(QLatin1Char('\n'));
+    qInfo().noquote() << "Connection attempt latencies:\n" + dump;
+    return dump;
+}
+
+void ConnectionHelper::resetLatencyStatistics()
+{
+    d_ptr->m_backend->resetLatencyHistograms();
+}
+
+void ConnectionHelper::recordAttemptLatency(bool established)
+{
+    if (!d_ptr->m_attemptTimer.isValid()) {
+        return;
+    }
+
+    const QString key = QStringLiteral("%1/%2/%3")
+            .arg(d_ptr->m_explicitAttempt ? QStringLiteral("explicit") : QStringLiteral("implicit"))
+            .arg(attemptPathName(d_ptr->m_attemptPath))
+            .arg(established ? QStringLiteral("established") : QStringLiteral("unavailable"));
+    d_ptr->m_backend->recordLatency(key, d_ptr->m_attemptTimer.elapsed());
+    d_ptr->m_attemptTimer.invalidate();
+}
+
 void ConnectionHelper::setSelectorVisible(bool selectorVisible)
 {
     if (d_ptr->m_selectorVisible != selectorVisible) {
@@ -189,6 +709,199 @@ void ConnectionHelper::updateStatus(ConnectionHelper::Status status)
                 || status == ConnectionHelper::Online) {
             emit onlineChanged();
         }
+        if (status == ConnectionHelper::Online && !d_ptr->m_jobs.isEmpty()) {
+            d_ptr->m_drainTimer.start(0);
+        }
+    }
+}
+
+/*
+    Queues a job to be run once the helper is Online. Jobs queued while
+    Online run on the next event loop iteration. All queued jobs are run
+    together, higher priority first, so that network traffic is batched
+    into a single radio wake-up. Jobs whose deadline, in milliseconds from
+    now, passes first are dropped and reported through jobExpired().
+
+    Queuing does not bring the network up; use requestNetwork() or
+    attemptToConnectNetwork() for that.
+
+    Returns an id for cancelJob().
+*/
+int ConnectionHelper::enqueue(const std::function<void()> &job, int priority, int deadline)
+{
+    ConnectionHelperPrivate::Job entry;
+    entry.id = d_ptr->m_nextJobId++;
+    entry.priority = priority;
+    entry.deadline = deadline >= 0 ? QDateTime::currentMSecsSinceEpoch() + deadline : 0;
+    entry.run = job;
+
+    int index = 0;
+    while (index < d_ptr->m_jobs.count() && d_ptr->m_jobs.at(index).priority >= priority) {
+        ++index;
+    }
+    d_ptr->m_jobs.insert(index, entry);
+
+    if (entry.deadline) {
+        scheduleJobExpiry();
+    }
+    if (d_ptr->m_status == ConnectionHelper::Online && !d_ptr->m_drainTimer.isActive()) {
+        d_ptr->m_drainTimer.start(0);
+    }
+    emit queuedJobCountChanged();
+    return entry.id;
+}
+
+/*
+    Queues a GET request, sent with the shared network access manager once
+    Online. The handler receives the reply and takes ownership of it.
+*/
+int ConnectionHelper::enqueueRequest(const QNetworkRequest &request,
+                                     const std::function<void(QNetworkReply *)> &handler,
+                                     int priority, int deadline)
+{
+    QSharedPointer<ConnectivityBackend> backend = d_ptr->m_backend;
+    return enqueue([backend, request, handler]() {
+        QNetworkReply *reply = backend->networkAccessManager()->get(request);
+        if (handler) {
+            handler(reply);
+        } else {
+            QObject::connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+        }
+    }, priority, deadline);
+}
+
+/*
+    QML variant of enqueue(), calling the given function once Online.
+*/
+int ConnectionHelper::enqueue(const QJSValue &callback, int priority, int deadline)
+{
+    if (!callback.isCallable()) {
+        qWarning() << "ConnectionHelper: enqueued job is not a function";
+        return 0;
+    }
+
+    return enqueue([callback]() {
+        QJSValue function(callback);
+        const QJSValue result = function.call();
+        if (result.isError()) {
+            qWarning() << "ConnectionHelper: queued job failed:" << result.toString();
+        }
+    }, priority, deadline);
+}
+
+bool ConnectionHelper::cancelJob(int id)
+{
+    for (int i = 0; i < d_ptr->m_jobs.count(); ++i) {
+        if (d_ptr->m_jobs.at(i).id == id) {
+            d_ptr->m_jobs.removeAt(i);
+            scheduleJobExpiry();
+            emit queuedJobCountChanged();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConnectionHelper::clearJobs()
+{
+    if (!d_ptr->m_jobs.isEmpty()) {
+        d_ptr->m_jobs.clear();
+        d_ptr->m_jobExpiryTimer.stop();
+        emit queuedJobCountChanged();
+    }
+}
+
+/*
+    The network access manager shared by all helpers in the process and
+    used for their canary requests and queued requests. The connection of
+    a successful canary request is kept in its pool, so a request to the
+    same status check host right after skips the TCP and TLS handshakes.
+    Remains valid as long as any helper exists.
+*/
+QNetworkAccessManager *ConnectionHelper::networkAccessManager() const
+{
+    return d_ptr->m_backend->networkAccessManager();
+}
+
+/*
+    Opens a connection to the host of url with the shared network access
+    manager once Online, ahead of the requests that will use it.
+*/
+void ConnectionHelper::preconnect(const QUrl &url)
+{
+    QSharedPointer<ConnectivityBackend> backend = d_ptr->m_backend;
+    // ahead of any requests queued for the same batch.
+    enqueue([backend, url]() {
+        QNetworkAccessManager *manager = backend->networkAccessManager();
+#ifndef QT_NO_SSL
+        if (url.scheme() == QLatin1String("https")) {
+            manager->connectToHostEncrypted(url.host(), url.port(443));
+            return;
+        }
+#endif
+        manager->connectToHost(url.host(), url.port(80));
+    }, std::numeric_limits<int>::max());
+}
+
+int ConnectionHelper::queuedJobCount() const
+{
+    return d_ptr->m_jobs.count();
+}
+
+void ConnectionHelper::drainJobs()
+{
+    if (d_ptr->m_status != ConnectionHelper::Online || d_ptr->m_jobs.isEmpty()) {
+        return;
+    }
+
+    // jobs may queue further jobs, those go to the next batch.
+    const QList<ConnectionHelperPrivate::Job> jobs = d_ptr->m_jobs;
+    d_ptr->m_jobs.clear();
+    d_ptr->m_jobExpiryTimer.stop();
+    emit queuedJobCountChanged();
+
+    QPointer<ConnectionHelper> guard(this);
+    for (const ConnectionHelperPrivate::Job &job : jobs) {
+        job.run();
+        if (!guard) {
+            return;
+        }
+    }
+}
+
+void ConnectionHelper::expireJobs()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<int> expired;
+    for (int i = d_ptr->m_jobs.count() - 1; i >= 0; --i) {
+        const qint64 deadline = d_ptr->m_jobs.at(i).deadline;
+        if (deadline && deadline <= now) {
+            expired.prepend(d_ptr->m_jobs.takeAt(i).id);
+        }
+    }
+
+    scheduleJobExpiry();
+    if (!expired.isEmpty()) {
+        emit queuedJobCountChanged();
+        for (int id : expired) {
+            emit jobExpired(id);
+        }
+    }
+}
+
+void ConnectionHelper::scheduleJobExpiry()
+{
+    qint64 earliest = 0;
+    for (const ConnectionHelperPrivate::Job &job : d_ptr->m_jobs) {
+        if (job.deadline && (!earliest || job.deadline < earliest)) {
+            earliest = job.deadline;
+        }
+    }
+
+    if (earliest) {
+        d_ptr->m_jobExpiryTimer.start(qMax<qint64>(0, earliest - QDateTime::currentMSecsSinceEpoch()));
+    } else {
+        d_ptr->m_jobExpiryTimer.stop();
     }
 }
 
@@ -211,6 +924,7 @@ void ConnectionHelper::updateStatus(ConnectionHelper::Status status)
 */
 void ConnectionHelper::attemptToConnectNetwork()
 {
+    cancelRetries();
     _attemptToConnectNetwork(true);
 }
 
@@ -220,12 +934,72 @@ void ConnectionHelper::attemptToConnectNetwork()
 */
 void ConnectionHelper::requestNetwork()
 {
+    cancelRetries();
+    _attemptToConnectNetwork(false);
+}
+
+/*
+    Stops the retries of a failed requestNetwork() scheduled according to
+    the policy's retryAttempts.
+*/
+void ConnectionHelper::cancelRetries()
+{
+    d_ptr->m_retryCount = 0;
+    if (d_ptr->m_retryTimer.isActive()) {
+        d_ptr->m_retryTimer.stop();
+        emit retryPendingChanged();
+    }
+}
+
+bool ConnectionHelper::retryPending() const
+{
+    return d_ptr->m_retryTimer.isActive();
+}
+
+void ConnectionHelper::scheduleRetry()
+{
+    if (d_ptr->m_retryCount >= policy()->retryAttempts()) {
+        d_ptr->m_retryCount = 0;
+        return;
+    }
+
+    const int maximumDelay = qMax(0, policy()->retryMaximumDelay());
+    qint64 delay = qMax(0, policy()->retryInitialDelay());
+    for (int i = 0; i < d_ptr->m_retryCount && delay < maximumDelay; ++i) {
+        delay *= 2;
+    }
+    delay = qMin<qint64>(delay, maximumDelay);
+
+    // full delay shortened by a random amount of up to a half.
+    const int jitter = int(delay / 2);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    delay -= jitter > 0 ? QRandomGenerator::global()->bounded(jitter + 1) : 0;
+#else
+    delay -= jitter > 0 ? qrand() % (jitter + 1) : 0;
+#endif
+
+    ++d_ptr->m_retryCount;
+    d_ptr->m_retryTimer.start(int(delay));
+    emit retryPendingChanged();
+}
+
+void ConnectionHelper::retryNetworkRequest()
+{
+    d_ptr->m_retryTimer.stop();
+    emit retryPendingChanged();
     _attemptToConnectNetwork(false);
 }
 
 void ConnectionHelper::_attemptToConnectNetwork(bool explicitAttempt)
 {
-    if (!d_ptr->m_connmanIsAvailable) {
+    // waiting for connman counts towards the latency too.
+    if (!d_ptr->m_detectingNetworkConnection && !d_ptr->m_attemptTimer.isValid()) {
+        d_ptr->m_attemptTimer.start();
+        d_ptr->m_explicitAttempt = explicitAttempt;
+        d_ptr->m_attemptPath = NoRoutePath;
+    }
+
+    if (!d_ptr->m_backend->connmanAvailable()) {
         d_ptr->m_delayedAttemptToConnect = true;
         return;
     }
@@ -239,19 +1013,26 @@ void ConnectionHelper::_attemptToConnectNetwork(bool explicitAttempt)
     // for explicit (UI-driven) flow, we will show the connection
     // selector dialog, etc, so allow plenty of time.
     d_ptr->m_detectingNetworkConnection = true;
+    d_ptr->m_probeRetriesLeft = policy()->probeRetries();
     updateStatus(ConnectionHelper::Connecting);
-    d_ptr->m_timeoutTimer.start(explicitAttempt ? 300000 : 5000); // 5 min/sec
+    if (policy()->prewarmConnectionSelector()) {
+        prewarmConnectionSelector();
+    }
+    d_ptr->m_timeoutTimer.start(explicitAttempt ? policy()->explicitTimeout()
+                                                : policy()->implicitTimeout());
 
     if (!d_ptr->m_netman->defaultRoute()) {
         emitFailureIfNeeded();
     } else if (d_ptr->m_netman->defaultRoute()->serviceState() == NetworkService::OnlineState) {
         // we are online and connman's online check has passed. Everything is ok
+        d_ptr->m_attemptPath = AlreadyOnlinePath;
         handleNetworkEstablished();
     } else if (explicitAttempt) {
         // even if we are in "ready" state (i.e. possibly able to connect, but possibly
         // not, due to captive portal), immediately show the connection selector UI.
         // we do this to avoid performing a network request which might have
         // significant latency, in the "explicit" (i.e. UI triggered) case.
+        d_ptr->m_attemptPath = SelectorPath;
         openConnectionDialog();
     } else if (d_ptr->m_netman->defaultRoute()->serviceState() == NetworkService::ReadyState) {
         // we already have an open session, but something isn't quite right.  Ensure that the
@@ -267,57 +1048,68 @@ void ConnectionHelper::performRequest()
 {
     // sometimes connman service can be in 'ready' state but can still be used.
     // In this case, let perform our own online check, just to be sure
+    startCanaryRequest(true);
+}
 
-    if (!d_ptr->m_networkAccessManager) {
-        d_ptr->m_networkAccessManager = new QNetworkAccessManager(this);
+void ConnectionHelper::startCanaryRequest(bool useCachedVerdict)
+{
+    if (d_ptr->m_canaryProbe) {
+        return;
     }
 
-    // Testing network connectivity, always load from network.
-    const QUrl networkStatusCheckUrl(d_ptr->m_defaultNetworkStatusCheckUrl);
-    QNetworkRequest request(networkStatusCheckUrl);
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
-                         QNetworkRequest::AlwaysNetwork);
-    QNetworkReply *reply = d_ptr->m_networkAccessManager->head(request);
-    if (!reply) {
-        QMetaObject::invokeMethod(this, "handleNetworkUnavailable", Qt::QueuedConnection);
+    // A recent probe on this very route already got through.
+    if (useCachedVerdict && d_ptr->m_backend->recentlyOnline(d_ptr->m_verdictTimeToLive)) {
+        if (d_ptr->m_attemptPath != SelectorPath) {
+            d_ptr->m_attemptPath = CachedVerdictPath;
+        }
+        handleCanaryRequestSucceeded();
         return;
     }
 
-    // We expect this request to succeed if the connection has been brought
-    // online successfully.  It may fail if, for example, the interface is waiting
-    // for a Captive Portal redirect, in which case we should consider network
-    // connectivity to be unavailable (as it requires user intervention).
-    connect(reply, &QNetworkReply::finished, this, &ConnectionHelper::handleCanaryRequestFinished);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    connect(reply, &QNetworkReply::error, this, &ConnectionHelper::handleCanaryRequestError);
-#else
-    connect(reply, static_cast<void (QNetworkReply::*)(QNetworkReply::NetworkError)>(&QNetworkReply::error),
-            this, &ConnectionHelper::handleCanaryRequestError);
-#endif
+    if (d_ptr->m_attemptPath != SelectorPath) {
+        d_ptr->m_attemptPath = ProbePath;
+    }
+
+    // Helpers asking at the same time share a single in-flight probe.
+    d_ptr->m_canaryProbe = d_ptr->m_backend->acquireProbe(
+                probeParameters(policy(), d_ptr->m_fallbackStatusCheckUrls));
+    connect(d_ptr->m_canaryProbe, &ConnectivityProbe::succeeded,
+            this, &ConnectionHelper::handleCanaryRequestSucceeded);
+    connect(d_ptr->m_canaryProbe, &ConnectivityProbe::failed,
+            this, &ConnectionHelper::handleCanaryRequestFailed);
 }
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-void ConnectionHelper::handleCanaryRequestError()
-#else
-void ConnectionHelper::handleCanaryRequestError(const QNetworkReply::NetworkError &)
-#endif
+
+void ConnectionHelper::releaseCanaryRequest()
+{
+    if (d_ptr->m_canaryProbe) {
+        disconnect(d_ptr->m_canaryProbe, nullptr, this, nullptr);
+        d_ptr->m_backend->releaseProbe(d_ptr->m_canaryProbe);
+        d_ptr->m_canaryProbe = nullptr;
+    }
+}
+
+void ConnectionHelper::handleCanaryRequestSucceeded()
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-    reply->setProperty("isError", QVariant::fromValue<bool>(true));
-    reply->deleteLater();
+    d_ptr->m_canaryProbe = nullptr;
     if (d_ptr->m_detectingNetworkConnection) {
-        networkConnectivityUnavailable();
+        handleNetworkEstablished();
     }
 }
 
-void ConnectionHelper::handleCanaryRequestFinished()
+void ConnectionHelper::handleCanaryRequestFailed()
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply->property("isError").toBool()) {
-        reply->deleteLater();
-        if (d_ptr->m_detectingNetworkConnection) {
-            handleNetworkEstablished();
-        }
+    d_ptr->m_canaryProbe = nullptr;
+    if (d_ptr->m_detectingNetworkConnection && d_ptr->m_timeoutTimer.isActive()
+            && d_ptr->m_probeRetriesLeft > 0) {
+        // the policy allows another go, the cached verdict is this failure.
+        --d_ptr->m_probeRetriesLeft;
+        startCanaryRequest(false);
+        return;
     }
+
+    // None of the status urls were reachable, or a Captive Portal answered
+    // which requires user intervention.
+    emitFailureIfNeeded();
 }
 
 void ConnectionHelper::emitFailureIfNeeded()
@@ -326,6 +1118,7 @@ void ConnectionHelper::emitFailureIfNeeded()
     // was queued, we should emit the error signal.
     if (d_ptr->m_detectingNetworkConnection && d_ptr->m_timeoutTimer.isActive()) {
         d_ptr->m_timeoutTimer.stop();
+        releaseCanaryRequest();
         QMetaObject::invokeMethod(this, "handleNetworkUnavailable", Qt::QueuedConnection);
     }
 }
@@ -334,29 +1127,26 @@ void ConnectionHelper::openConnectionDialog()
 {
     // open Connection Selector
 
-    if (!d_ptr->m_connectionSelectorInterface) {
-        QDBusConnection connection = QDBusConnection::sessionBus();
-
-        d_ptr->m_connectionSelectorInterface = new QDBusInterface(
-                    QStringLiteral("com.jolla.lipstick.ConnectionSelector"),
-                    QStringLiteral("/"),
-                    QStringLiteral("com.jolla.lipstick.ConnectionSelectorIf"),
-                    connection,
-                    this);
-
-        connection.connect(
-                    QStringLiteral("com.jolla.lipstick.ConnectionSelector"),
-                    QStringLiteral("/"),
-                    QStringLiteral("com.jolla.lipstick.ConnectionSelectorIf"),
+    // plain messages rather than a QDBusInterface, which would introspect
+    // the service synchronously.
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    if (!d_ptr->m_connectionSelectorConnected) {
+        d_ptr->m_connectionSelectorConnected = connection.connect(
+                    ConnectionSelectorService,
+                    ConnectionSelectorPath,
+                    ConnectionSelectorInterface,
                     QStringLiteral("connectionSelectorClosed"),
                     this,
                     SLOT(handleConnectionSelectorClosed(bool)));
     }
 
-    QList<QVariant> args;
-    args.append(QStringLiteral("wifi"));
-    QDBusPendingCall call = d_ptr->m_connectionSelectorInterface->asyncCallWithArgumentList(
-                QStringLiteral("openConnectionNow"), args);
+    QDBusMessage message = QDBusMessage::createMethodCall(
+                ConnectionSelectorService,
+                ConnectionSelectorPath,
+                ConnectionSelectorInterface,
+                QStringLiteral("openConnectionNow"));
+    message.setArguments(QVariantList() << QStringLiteral("wifi"));
+    QDBusPendingCall call = connection.asyncCall(message);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
     connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher] {
         watcher->deleteLater();
@@ -369,6 +1159,26 @@ void ConnectionHelper::openConnectionDialog()
     });
 }
 
+/*
+    Has D-Bus activate the connection selector service without waiting for
+    the reply, so that it is already running if the dialog is needed.
+*/
+void ConnectionHelper::prewarmConnectionSelector()
+{
+    if (d_ptr->m_connectionSelectorPrewarmed) {
+        return;
+    }
+    d_ptr->m_connectionSelectorPrewarmed = true;
+
+    QDBusMessage message = QDBusMessage::createMethodCall(
+                QStringLiteral("org.freedesktop.DBus"),
+                QStringLiteral("/org/freedesktop/DBus"),
+                QStringLiteral("org.freedesktop.DBus"),
+                QStringLiteral("StartServiceByName"));
+    message.setArguments(QVariantList() << ConnectionSelectorService << 0u);
+    QDBusConnection::sessionBus().send(message);
+}
+
 void ConnectionHelper::handleConnectionSelectorClosed(bool connectionSelected)
 {
     if (!connectionSelected) {
@@ -388,8 +1198,54 @@ void ConnectionHelper::serviceErrorChanged(const QString &errorString)
     handleNetworkUnavailable();
 }
 
+/*
+    With a debounce window in the policy, state changes are collected
+    until the window since the first one has passed and only the last
+    state is applied, so a flap back to the applied state changes nothing.
+    Offline states are applied within maximumOfflineDelay of arriving.
+*/
 void ConnectionHelper::networkStateChanged(const QString &state)
 {
+    d_ptr->m_pendingNetworkState = state;
+
+    if (d_ptr->m_retryTimer.isActive() && (state == "ready" || state == "online")) {
+        // no point in waiting out the backoff once there is a route.
+        retryNetworkRequest();
+    }
+
+    const int window = policy()->stateDebounceWindow();
+    if (window <= 0) {
+        d_ptr->m_stateDebounceTimer.stop();
+        applyNetworkState();
+        return;
+    }
+
+    if (!d_ptr->m_stateDebounceTimer.isActive()) {
+        d_ptr->m_stateDebounceStarted.start();
+        d_ptr->m_stateDebounceTimer.start(window);
+    }
+
+    if (state == "idle" || state == "offline") {
+        const int remaining = window - d_ptr->m_stateDebounceStarted.elapsed();
+        const int bound = qMax(0, policy()->maximumOfflineDelay());
+        if (bound < remaining) {
+            d_ptr->m_stateDebounceTimer.start(bound);
+        }
+    }
+}
+
+void ConnectionHelper::applyNetworkState()
+{
+    const QString state = d_ptr->m_pendingNetworkState;
+    if (d_ptr->m_stateDebounceStarted.isValid()) {
+        d_ptr->m_stateDebounceStarted.invalidate();
+        if (state == d_ptr->m_appliedNetworkState) {
+            // flapped back to where it was.
+            return;
+        }
+    }
+    d_ptr->m_appliedNetworkState = state;
+
     if (state == "online") {
         handleNetworkEstablished();
     } else if (state == "ready") {
@@ -403,14 +1259,23 @@ void ConnectionHelper::networkStateChanged(const QString &state)
 void ConnectionHelper::handleNetworkEstablished()
 {
     d_ptr->m_detectingNetworkConnection = false;
+    d_ptr->m_timeoutTimer.stop();
+    releaseCanaryRequest();
+    cancelRetries();
+    recordAttemptLatency(true);
     updateStatus(ConnectionHelper::Online);
     emit networkConnectivityEstablished();
 }
 
 void ConnectionHelper::handleNetworkUnavailable()
 {
+    const bool attemptFailed = d_ptr->m_detectingNetworkConnection;
     d_ptr->m_detectingNetworkConnection = false;
+    recordAttemptLatency(false);
     updateStatus(ConnectionHelper::Offline);
+    if (attemptFailed && !d_ptr->m_explicitAttempt) {
+        scheduleRetry();
+    }
     emit networkConnectivityUnavailable();
 }
 
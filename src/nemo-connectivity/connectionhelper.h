@@ -33,6 +33,8 @@
 #define NEMO_CONNECTION_HELPER_H
 
 #include <QObject>
+#include <QMap>
+#include <QStringList>
 #include <QTimer>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -42,13 +44,25 @@
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include <functional>
 
 #include <nemo-connectivity/global.h>
+#include <nemo-connectivity/connectivitypolicy.h>
+#include <nemo-connectivity/latencyhistogram.h>
+#include <nemo-connectivity/linkquality.h>
+#include <nemo-connectivity/networkrequirement.h>
 
 QT_BEGIN_NAMESPACE
-class QDBusInterface;
+class QJSValue;
 QT_END_NAMESPACE
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+// for the generated meta-object only, C++ users need not link QtQml.
+Q_MOC_INCLUDE(<QJSValue>)
+#endif
+
 class ConnectionHelperPrivate;
 
 namespace Nemo {
@@ -59,6 +73,20 @@ class NEMO_CONNECTIVITY_EXPORT ConnectionHelper : public QObject
     Q_PROPERTY(bool online READ online NOTIFY onlineChanged)
     Q_PROPERTY(bool selectorVisible READ selectorVisible NOTIFY selectorVisibleChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(bool ready READ ready NOTIFY readyChanged)
+    Q_PROPERTY(QStringList fallbackStatusUrls READ fallbackStatusUrls WRITE setFallbackStatusUrls NOTIFY fallbackStatusUrlsChanged)
+    Q_PROPERTY(int verdictTimeToLive READ verdictTimeToLive WRITE setVerdictTimeToLive NOTIFY verdictTimeToLiveChanged)
+    Q_PROPERTY(Nemo::ConnectivityPolicy *policy READ policy WRITE setPolicy NOTIFY policyChanged)
+    Q_PROPERTY(int rtt READ rtt NOTIFY linkQualityChanged)
+    Q_PROPERTY(int jitter READ jitter NOTIFY linkQualityChanged)
+    Q_PROPERTY(int bandwidth READ bandwidth NOTIFY linkQualityChanged)
+    Q_PROPERTY(QVariantMap lastProbeTiming READ lastProbeTiming NOTIFY linkQualityChanged)
+    Q_PROPERTY(int queuedJobCount READ queuedJobCount NOTIFY queuedJobCountChanged)
+    Q_PROPERTY(bool retryPending READ retryPending NOTIFY retryPendingChanged)
+    Q_PROPERTY(bool monitoring READ monitoring WRITE setMonitoring NOTIFY monitoringChanged)
+    Q_PROPERTY(bool stallDetection READ stallDetection WRITE setStallDetection NOTIFY stallDetectionChanged)
+    Q_PROPERTY(bool linkWatching READ linkWatching WRITE setLinkWatching NOTIFY linkWatchingChanged)
+    Q_PROPERTY(QStringList warmUpHosts READ warmUpHosts WRITE setWarmUpHosts NOTIFY warmUpHostsChanged)
 
 public:
     ConnectionHelper(QObject *parent = 0);
@@ -66,6 +94,9 @@ public:
 
     Q_INVOKABLE void attemptToConnectNetwork();
     Q_INVOKABLE void requestNetwork();
+    Q_INVOKABLE void cancelRetries();
+    Q_INVOKABLE void preconnect(const QUrl &url);
+    bool retryPending() const;
 
     bool selectorVisible() const;
     bool online() const;
@@ -80,21 +111,81 @@ public:
     Q_ENUM(Status)
     Status status() const;
 
+    bool ready() const;
+
+    QStringList fallbackStatusUrls() const;
+    void setFallbackStatusUrls(const QStringList &urls);
+
+    int verdictTimeToLive() const;
+    void setVerdictTimeToLive(int timeToLive);
+
+    ConnectivityPolicy *policy() const;
+    void setPolicy(ConnectivityPolicy *policy);
+
+    bool monitoring() const;
+    void setMonitoring(bool monitoring);
+
+    bool stallDetection() const;
+    void setStallDetection(bool stallDetection);
+
+    bool linkWatching() const;
+    void setLinkWatching(bool linkWatching);
+
+    QStringList warmUpHosts() const;
+    void setWarmUpHosts(const QStringList &hosts);
+    Q_INVOKABLE QVariantMap resolverStatistics() const;
+
+    Q_INVOKABLE void addRequirement(Nemo::NetworkRequirement *requirement);
+    Q_INVOKABLE void removeRequirement(Nemo::NetworkRequirement *requirement);
+
+    LinkQuality linkQuality() const;
+    int rtt() const;
+    int jitter() const;
+    int bandwidth() const;
+    QVariantMap lastProbeTiming() const;
+
+    QMap<QString, LatencyHistogram> latencyHistograms() const;
+    Q_INVOKABLE QVariantMap latencyStatistics() const;
+    Q_INVOKABLE QString dumpLatencyStatistics() const;
+    Q_INVOKABLE void resetLatencyStatistics();
+
+    int enqueue(const std::function<void()> &job, int priority = 0, int deadline = -1);
+    int enqueueRequest(const QNetworkRequest &request,
+                       const std::function<void(QNetworkReply *)> &handler,
+                       int priority = 0, int deadline = -1);
+    Q_INVOKABLE int enqueue(const QJSValue &callback, int priority = 0, int deadline = -1);
+    Q_INVOKABLE bool cancelJob(int id);
+    Q_INVOKABLE void clearJobs();
+    int queuedJobCount() const;
+
+    QNetworkAccessManager *networkAccessManager() const;
+
 Q_SIGNALS:
     void networkConnectivityEstablished();
     void networkConnectivityUnavailable();
     void onlineChanged();
     void selectorVisibleChanged();
     void statusChanged();
+    void readyChanged();
+    void fallbackStatusUrlsChanged();
+    void verdictTimeToLiveChanged();
+    void policyChanged();
+    void linkQualityChanged();
+    void queuedJobCountChanged();
+    void jobExpired(int id);
+    void retryPendingChanged();
+    void monitoringChanged();
+    void stallDetectionChanged();
+    void linkWatchingChanged();
+    void warmUpHostsChanged();
+    void requirementAvailable(Nemo::NetworkRequirement *requirement);
+    void requirementLost(Nemo::NetworkRequirement *requirement);
+    void handover(const QVariantMap &previous, const QVariantMap &current);
 
 private Q_SLOTS:
     void performRequest();
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    void handleCanaryRequestError();
-#else
-    void handleCanaryRequestError(const QNetworkReply::NetworkError &error);
-#endif
-    void handleCanaryRequestFinished();
+    void handleCanaryRequestSucceeded();
+    void handleCanaryRequestFailed();
     void emitFailureIfNeeded(); // due to timeout.
 
     void handleNetworkEstablished();
@@ -103,15 +194,29 @@ private Q_SLOTS:
     void connmanAvailableChanged(bool);
     void serviceErrorChanged(const QString &);
     void networkStateChanged(const QString &);
+    void applyNetworkState();
     void openConnectionDialog();
-
-    void getConnmanManagerProperties(const QVariantMap &props);
+    void prewarmConnectionSelector();
+    void drainJobs();
+    void expireJobs();
+    void retryNetworkRequest();
+    void handleMonitorVerdict(bool online);
+    void handleStallDetected();
+    void handleLinkLost();
+    void handleAddressLost();
+    void handleHandover(const QVariantMap &previous, const QVariantMap &current);
 
 private:
     void updateStatus(Status status);
-    void determineDefaultNetworkStatusCheckUrl();
+    void startCanaryRequest(bool useCachedVerdict);
+    void releaseCanaryRequest();
+    void recordAttemptLatency(bool established);
     void _attemptToConnectNetwork(bool explicitAttempt);
     void setSelectorVisible(bool selectorVisible);
+    void scheduleJobExpiry();
+    void scheduleRetry();
+    void connectPolicy();
+    void updateMonitor();
 
 private:
     ConnectionHelperPrivate *d_ptr;
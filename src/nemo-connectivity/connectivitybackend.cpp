@@ -0,0 +1,1208 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "connectivitybackend_p.h"
+#include "connectivityprobe_p.h"
+#include "linkwatcher_p.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QGuiApplication>
+#include <QHostInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkInterface>
+#include <QNetworkReply>
+#include <QUrl>
+#include <QWeakPointer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <connman-qt6/networkmanager.h>
+#include <connman-qt6/networkservice.h>
+#else
+#include <connman-qt5/networkmanager.h>
+#include <connman-qt5/networkservice.h>
+#endif
+
+namespace {
+
+QWeakPointer<Nemo::ConnectivityBackend> sharedBackend;
+
+// Background verification backs off while the verdict stays online.
+const int MinimumMonitorInterval = 30000; // 30 sec
+const int MaximumMonitorInterval = 1800000; // 30 min
+
+// Background checks are due on wall clock multiples of this, so that the
+// checks of all processes using this library wake the device up together.
+const int MonitorAlignment = 10000; // 10 sec
+
+int alignedDelay(int delay, int alignment)
+{
+    const qint64 due = QDateTime::currentMSecsSinceEpoch() + delay;
+    return delay + int((alignment - due % alignment) % alignment);
+}
+
+// Packets sent without any received for this long suggest a stalled link.
+const int StallSampleInterval = 2000; // 2 sec
+const int StallWindow = 8000; // 8 sec
+
+// Only downloads this large tell anything about the bandwidth.
+const qint64 MinimumThroughputSample = 64 * 1024;
+
+/*
+    Times the replies it creates, from their headers to their completion,
+    to estimate the bandwidth from the large ones.
+*/
+class MeasuringNetworkAccessManager : public QNetworkAccessManager
+{
+public:
+    MeasuringNetworkAccessManager(Nemo::ConnectivityBackend *backend)
+        : QNetworkAccessManager(backend)
+        , m_backend(backend)
+    {
+    }
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData) override
+    {
+        QNetworkReply *reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+        if (op != GetOperation) {
+            return reply;
+        }
+
+        QSharedPointer<QElapsedTimer> timer(new QElapsedTimer);
+        QSharedPointer<qint64> received(new qint64(0));
+        connect(reply, &QNetworkReply::metaDataChanged, reply, [timer] {
+            if (!timer->isValid()) {
+                timer->start();
+            }
+        });
+        connect(reply, &QNetworkReply::downloadProgress, reply, [received](qint64 bytes, qint64) {
+            *received = bytes;
+        });
+        Nemo::ConnectivityBackend *backend = m_backend;
+        connect(reply, &QNetworkReply::finished, backend, [backend, reply, timer, received] {
+            if (timer->isValid() && reply->error() == QNetworkReply::NoError
+                    && *received >= MinimumThroughputSample) {
+                QMetaObject::invokeMethod(backend, "recordThroughput",
+                                          Q_ARG(qint64, *received),
+                                          Q_ARG(qint64, timer->elapsed()));
+            }
+        });
+        return reply;
+    }
+
+private:
+    Nemo::ConnectivityBackend *m_backend;
+};
+
+bool readInterfaceCounter(const QString &interface, const char *counter, quint64 *value)
+{
+    QFile file(QStringLiteral("/sys/class/net/%1/statistics/%2")
+               .arg(interface, QLatin1String(counter)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    bool ok = false;
+    *value = file.readAll().trimmed().toULongLong(&ok);
+    return ok;
+}
+
+}
+
+namespace Nemo {
+
+ConnectivityBackend::ConnectivityBackend()
+    : m_netman(NetworkManager::sharedInstance())
+    , m_networkAccessManager(new MeasuringNetworkAccessManager(this))
+    , m_verdictServiceState(NetworkService::UnknownState)
+    , m_smoothedRtt(0)
+    , m_rttVariation(0)
+    , m_ready(false)
+    , m_connmanAvailable(false)
+    , m_statusCheckUrlsPending(false)
+    , m_monitorProbe(nullptr)
+    , m_monitorInterval(MinimumMonitorInterval)
+    , m_monitorOnline(false)
+    , m_stallRxPackets(0)
+    , m_stallTxPackets(0)
+    , m_stalled(false)
+    , m_linkWatcher(nullptr)
+    , m_defaultRouteAddressed(true)
+    , m_routeUsable(false)
+    , m_displayOn(true)
+    , m_applicationActive(true)
+{
+    m_monitorTimer.setSingleShot(true);
+    m_monitorTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&m_monitorTimer, &QTimer::timeout,
+            this, &ConnectivityBackend::runMonitorProbe);
+    m_stallTimer.setTimerType(Qt::CoarseTimer);
+    connect(&m_stallTimer, &QTimer::timeout,
+            this, &ConnectivityBackend::sampleInterfaceCounters);
+
+    // Background work is paused while nobody is looking. The display state
+    // comes from mce, the application state from QGuiApplication when the
+    // process has one.
+    QDBusConnection systemBus = QDBusConnection::systemBus();
+    systemBus.connect(QStringLiteral("com.nokia.mce"),
+                      QStringLiteral("/com/nokia/mce/signal"),
+                      QStringLiteral("com.nokia.mce.signal"),
+                      QStringLiteral("display_status_ind"),
+                      this, SLOT(handleDisplayStatus(QString)));
+    systemBus.callWithCallback(
+            QDBusMessage::createMethodCall(QStringLiteral("com.nokia.mce"),
+                                           QStringLiteral("/com/nokia/mce/request"),
+                                           QStringLiteral("com.nokia.mce.request"),
+                                           QStringLiteral("get_display_status")),
+            this, SLOT(handleDisplayStatus(QString)));
+
+    QGuiApplication *application = qobject_cast<QGuiApplication *>(QCoreApplication::instance());
+    if (application) {
+        // e.g. started in the background, before any change is signalled.
+        m_applicationActive = QGuiApplication::applicationState() == Qt::ApplicationActive;
+        connect(application, &QGuiApplication::applicationStateChanged,
+                this, &ConnectivityBackend::handleApplicationStateChanged);
+    }
+
+    connect(m_netman.data(), &NetworkManager::availabilityChanged,
+            this, &ConnectivityBackend::setConnmanAvailable);
+    connect(m_netman.data(), &NetworkManager::stateChanged,
+            this, &ConnectivityBackend::handleNetworkStateChanged);
+    connect(m_netman.data(), &NetworkManager::defaultRouteChanged,
+            this, &ConnectivityBackend::handleDefaultRouteChanged);
+
+    connect(m_netman.data(), &NetworkManager::servicesChanged, this, [this] {
+        updateCapabilityWatch();
+        updateCapabilities();
+    });
+    connect(this, &ConnectivityBackend::linkQualityChanged,
+            this, &ConnectivityBackend::updateCapabilities);
+
+    m_defaultRouteInfo = defaultRouteInfo();
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    updateCapabilityWatch();
+    m_capabilities = currentCapabilities();
+    m_routeUsable = defaultRoute && (defaultRoute->serviceState() == NetworkService::ReadyState
+                                     || defaultRoute->serviceState() == NetworkService::OnlineState);
+    determineConnmanAvailable();
+}
+
+ConnectivityBackend::~ConnectivityBackend()
+{
+    // abort pending replies before the network access manager goes away.
+    for (const PendingProbe &pending : m_probes) {
+        delete pending.probe;
+    }
+    for (auto it = m_warmUps.constBegin(); it != m_warmUps.constEnd(); ++it) {
+        QHostInfo::abortHostLookup(it.key());
+    }
+}
+
+QSharedPointer<ConnectivityBackend> ConnectivityBackend::sharedInstance()
+{
+    QSharedPointer<ConnectivityBackend> backend = sharedBackend.toStrongRef();
+    if (!backend) {
+        // the last helper may go away while handling one of our signals.
+        backend = QSharedPointer<ConnectivityBackend>(new ConnectivityBackend, &QObject::deleteLater);
+        sharedBackend = backend;
+    }
+    return backend;
+}
+
+QSharedPointer<NetworkManager> ConnectivityBackend::networkManager() const
+{
+    return m_netman;
+}
+
+QNetworkAccessManager *ConnectivityBackend::networkAccessManager() const
+{
+    return m_networkAccessManager;
+}
+
+bool ConnectivityBackend::ready() const
+{
+    return m_ready;
+}
+
+bool ConnectivityBackend::connmanAvailable() const
+{
+    return m_connmanAvailable;
+}
+
+void ConnectivityBackend::determineConnmanAvailable()
+{
+    // Ask the bus without blocking, availabilityChanged covers later changes.
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.DBus"),
+                                                          QStringLiteral("/org/freedesktop/DBus"),
+                                                          QStringLiteral("org.freedesktop.DBus"),
+                                                          QStringLiteral("NameHasOwner"));
+    message << QStringLiteral("net.connman");
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        QDBusPendingReply<bool> reply = *watcher;
+        if (m_ready) {
+            // availabilityChanged got here first.
+            return;
+        }
+        if (reply.isError()) {
+            qWarning() << "Unable to determine connman availability:" << reply.error().message();
+        }
+        setConnmanAvailable(!reply.isError() && reply.value());
+    });
+}
+
+void ConnectivityBackend::setConnmanAvailable(bool available)
+{
+    if (available) {
+        // connman (re)started, the status check urls may have changed.
+        determineStatusCheckUrls();
+    }
+
+    if (m_connmanAvailable != available) {
+        m_connmanAvailable = available;
+        emit connmanAvailableChanged(available);
+    }
+
+    if (!m_ready) {
+        m_ready = true;
+        emit readyChanged();
+    }
+}
+
+void ConnectivityBackend::handleNetworkStateChanged(const QString &state)
+{
+    clearVerdict();
+    restartMonitoring();
+    updateStallSampling();
+    updateWarmUp(false);
+    emit networkStateChanged(state);
+    updateCapabilities();
+}
+
+void ConnectivityBackend::handleDefaultRouteChanged()
+{
+    clearVerdict();
+    restartMonitoring();
+    updateStallSampling();
+    m_defaultRouteAddressed = true;
+
+    // a switch between usable routes, e.g. from WLAN to cellular, rather
+    // than connecting or disconnecting.
+    const QVariantMap previous = m_defaultRouteInfo;
+    m_defaultRouteInfo = defaultRouteInfo();
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (!previous.isEmpty() && !m_defaultRouteInfo.isEmpty()
+            && previous.value(QStringLiteral("service")) != m_defaultRouteInfo.value(QStringLiteral("service"))
+            && (defaultRoute->serviceState() == NetworkService::ReadyState
+                || defaultRoute->serviceState() == NetworkService::OnlineState)) {
+        emit handover(previous, m_defaultRouteInfo);
+    }
+    updateWarmUp(true);
+
+    updateCapabilityWatch();
+
+    // a different link, start estimating afresh.
+    if (m_linkQuality.samples > 0 || m_linkQuality.bandwidth >= 0
+            || m_linkQuality.lastProbe.total >= 0) {
+        m_linkQuality = LinkQuality();
+        emit linkQualityChanged();
+    } else {
+        updateCapabilities();
+    }
+}
+
+void ConnectivityBackend::recordThroughput(qint64 bytes, qint64 milliseconds)
+{
+    const int sample = int(bytes * 8 / qMax<qint64>(milliseconds, 1)); // kbit/s
+    if (m_linkQuality.bandwidth < 0) {
+        m_linkQuality.bandwidth = sample;
+    } else {
+        m_linkQuality.bandwidth = qRound(0.75 * m_linkQuality.bandwidth + 0.25 * sample);
+    }
+    emit linkQualityChanged();
+}
+
+NetworkCapabilities::NetworkCapabilities()
+    : online(false)
+    , metered(false)
+    , roaming(false)
+    , vpn(false)
+    , bandwidth(-1)
+    , rtt(-1)
+{
+}
+
+bool NetworkCapabilities::operator==(const NetworkCapabilities &other) const
+{
+    return online == other.online
+            && metered == other.metered
+            && roaming == other.roaming
+            && vpn == other.vpn
+            && bandwidth == other.bandwidth
+            && rtt == other.rtt;
+}
+
+bool NetworkCapabilities::operator!=(const NetworkCapabilities &other) const
+{
+    return !(*this == other);
+}
+
+bool NetworkCapabilities::satisfies(const NetworkRequirement &requirement) const
+{
+    return online
+            && !(requirement.unmetered() && metered)
+            && !(requirement.notRoaming() && roaming)
+            && !(requirement.vpn() && !vpn)
+            && !(requirement.minimumBandwidth() > 0 && bandwidth >= 0
+                 && bandwidth < requirement.minimumBandwidth())
+            && !(requirement.maximumRtt() > 0 && rtt >= 0 && rtt > requirement.maximumRtt());
+}
+
+NetworkCapabilities ConnectivityBackend::capabilities() const
+{
+    return m_capabilities;
+}
+
+/*
+    Evaluates what the default route offers once for every requirement,
+    which are only told when that actually changed.
+*/
+void ConnectivityBackend::updateCapabilities()
+{
+    const NetworkCapabilities capabilities = currentCapabilities();
+    if (capabilities != m_capabilities) {
+        m_capabilities = capabilities;
+        emit capabilitiesChanged();
+    }
+}
+
+NetworkCapabilities ConnectivityBackend::currentCapabilities() const
+{
+    NetworkCapabilities capabilities;
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (!defaultRoute) {
+        return capabilities;
+    }
+
+    // online per connman, or per our own canary requests when connman's
+    // check is not conclusive.
+    capabilities.online = defaultRoute->serviceState() == NetworkService::OnlineState
+            || (defaultRoute->serviceState() == NetworkService::ReadyState
+                && m_verdictTimer.isValid()
+                && m_verdictServicePath == defaultRoute->path());
+    NetworkService *transport = transportService();
+    capabilities.metered = transport && transport->type() == QLatin1String("cellular");
+    capabilities.roaming = transport && transport->roaming();
+    capabilities.bandwidth = m_linkQuality.bandwidth;
+    capabilities.rtt = m_linkQuality.rtt;
+
+    const auto vpnServices = m_netman->getServices(QStringLiteral("vpn"));
+    for (NetworkService *service : vpnServices) {
+        if (service->connected()) {
+            capabilities.vpn = true;
+            break;
+        }
+    }
+
+    return capabilities;
+}
+
+/*
+    The service carrying the traffic of the default route: the route
+    itself, or for a VPN the connected service it runs over, which is the
+    first one in connman's order.
+*/
+NetworkService *ConnectivityBackend::transportService() const
+{
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (!defaultRoute || defaultRoute->type() != QLatin1String("vpn")) {
+        return defaultRoute;
+    }
+
+    const auto services = m_netman->getServices();
+    for (NetworkService *service : services) {
+        if (service->connected() && service->type() != QLatin1String("vpn")) {
+            return service;
+        }
+    }
+    return nullptr;
+}
+
+/*
+    Follows the properties capabilities() depends on beyond the default
+    route and the list of services: roaming of the transport and VPNs
+    connecting or disconnecting on their own.
+*/
+void ConnectivityBackend::updateCapabilityWatch()
+{
+    NetworkService *transport = transportService();
+    if (m_capabilityRoute != transport) {
+        if (m_capabilityRoute) {
+            disconnect(m_capabilityRoute.data(), &NetworkService::roamingChanged,
+                       this, &ConnectivityBackend::updateCapabilities);
+        }
+        m_capabilityRoute = transport;
+        if (transport) {
+            connect(transport, &NetworkService::roamingChanged,
+                    this, &ConnectivityBackend::updateCapabilities);
+        }
+    }
+
+    const auto vpnServices = m_netman->getServices(QStringLiteral("vpn"));
+    for (NetworkService *service : vpnServices) {
+        connect(service, &NetworkService::connectedChanged,
+                this, &ConnectivityBackend::updateCapabilities, Qt::UniqueConnection);
+    }
+}
+
+void ConnectivityBackend::clearVerdict()
+{
+    m_verdictTimer.invalidate();
+}
+
+LinkQuality ConnectivityBackend::linkQuality() const
+{
+    return m_linkQuality;
+}
+
+void ConnectivityBackend::updateLinkQuality(const ProbeTiming &timing, int rttSample, bool newTlsConnection)
+{
+    if (timing.dnsLookup >= 0) {
+        recordResolverLatency(defaultRouteInterface(), timing.dnsLookup, false);
+    }
+
+    if (rttSample >= 0) {
+        // RFC 6298 smoothing, as TCP does for its retransmission timer.
+        if (m_linkQuality.samples == 0) {
+            m_smoothedRtt = rttSample;
+            m_rttVariation = rttSample / 2.0;
+        } else {
+            m_rttVariation = 0.75 * m_rttVariation + 0.25 * qAbs(m_smoothedRtt - rttSample);
+            m_smoothedRtt = 0.875 * m_smoothedRtt + 0.125 * rttSample;
+        }
+        ++m_linkQuality.samples;
+        m_linkQuality.rtt = qRound(m_smoothedRtt);
+        m_linkQuality.jitter = qRound(m_rttVariation);
+    }
+
+    m_linkQuality.lastProbe = timing;
+    if (newTlsConnection && timing.connect >= 0 && m_linkQuality.rtt >= 0) {
+        // the TCP handshake took about one round trip, TLS the rest.
+        m_linkQuality.lastProbe.tlsHandshake = qMax(0, timing.connect - m_linkQuality.rtt);
+    }
+
+    emit linkQualityChanged();
+}
+
+bool ConnectivityBackend::recentlyOnline(int maxAge) const
+{
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (maxAge <= 0 || !defaultRoute || !m_verdictTimer.isValid()
+            || m_verdictTimer.hasExpired(maxAge)
+            || defaultRoute->path() != m_verdictServicePath
+            || defaultRoute->serviceState() != m_verdictServiceState) {
+        return false;
+    }
+
+    return true;
+}
+
+void ConnectivityBackend::recordLatency(const QString &key, qint64 milliseconds)
+{
+    m_latencyHistograms[key].add(milliseconds);
+}
+
+QMap<QString, LatencyHistogram> ConnectivityBackend::latencyHistograms() const
+{
+    return m_latencyHistograms;
+}
+
+void ConnectivityBackend::resetLatencyHistograms()
+{
+    m_latencyHistograms.clear();
+}
+
+void ConnectivityBackend::addMonitor(QObject *client, const ProbeParameters &parameters)
+{
+    for (Monitor &monitor : m_monitors) {
+        if (monitor.client == client) {
+            monitor.parameters = parameters;
+            return;
+        }
+    }
+
+    Monitor monitor;
+    monitor.client = client;
+    monitor.parameters = parameters;
+    m_monitors.append(monitor);
+
+    if (m_monitors.count() == 1) {
+        restartMonitoring();
+    }
+}
+
+void ConnectivityBackend::removeMonitor(QObject *client)
+{
+    for (int i = 0; i < m_monitors.count(); ++i) {
+        if (m_monitors.at(i).client == client) {
+            m_monitors.removeAt(i);
+            break;
+        }
+    }
+
+    if (m_monitors.isEmpty()) {
+        m_monitorTimer.stop();
+        if (m_monitorProbe && m_stallWatchers.isEmpty() && m_linkWatchers.isEmpty()) {
+            ConnectivityProbe *probe = m_monitorProbe;
+            m_monitorProbe = nullptr;
+            releaseProbe(probe);
+        }
+    }
+}
+
+/*
+    Something changed, so verify again soon rather than after the
+    interval reached while stable.
+*/
+void ConnectivityBackend::restartMonitoring()
+{
+    if (m_monitors.isEmpty()) {
+        return;
+    }
+
+    if (m_monitorProbe) {
+        // measured on what may no longer be the route.
+        ConnectivityProbe *probe = m_monitorProbe;
+        m_monitorProbe = nullptr;
+        releaseProbe(probe);
+    }
+
+    m_monitorInterval = MinimumMonitorInterval;
+    startMonitorTimer();
+}
+
+void ConnectivityBackend::startMonitorTimer()
+{
+    if (m_monitors.isEmpty() || !backgroundWorkAllowed()) {
+        m_monitorTimer.stop();
+        return;
+    }
+
+    m_monitorTimer.start(alignedDelay(m_monitorInterval, MonitorAlignment));
+}
+
+bool ConnectivityBackend::backgroundWorkAllowed() const
+{
+    return m_displayOn && m_applicationActive;
+}
+
+void ConnectivityBackend::handleDisplayStatus(const QString &status)
+{
+    // dimmed still counts as on.
+    setBackgroundWorkAllowed(status != QLatin1String("off"), m_applicationActive);
+}
+
+void ConnectivityBackend::handleApplicationStateChanged(Qt::ApplicationState state)
+{
+    setBackgroundWorkAllowed(m_displayOn, state == Qt::ApplicationActive);
+}
+
+void ConnectivityBackend::setBackgroundWorkAllowed(bool displayOn, bool applicationActive)
+{
+    const bool wasAllowed = backgroundWorkAllowed();
+    m_displayOn = displayOn;
+    m_applicationActive = applicationActive;
+    if (wasAllowed == backgroundWorkAllowed()) {
+        return;
+    }
+
+    // things may have changed meanwhile, check soon after resuming.
+    restartMonitoring();
+    updateStallSampling();
+}
+
+void ConnectivityBackend::runMonitorProbe()
+{
+    if (!m_monitors.isEmpty() && backgroundWorkAllowed()) {
+        startVerificationProbe(m_monitors.first().parameters);
+    }
+}
+
+void ConnectivityBackend::startVerificationProbe(const ProbeParameters &parameters)
+{
+    if (m_monitorProbe) {
+        return;
+    }
+
+    // without a usable route there is nothing to verify, a state or
+    // route change restarts the monitoring.
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (!defaultRoute || (defaultRoute->serviceState() != NetworkService::ReadyState
+                          && defaultRoute->serviceState() != NetworkService::OnlineState)) {
+        return;
+    }
+
+    ConnectivityProbe *probe = acquireProbe(parameters);
+    m_monitorProbe = probe;
+    m_monitorProbeService = defaultRoute->path();
+    connect(probe, &ConnectivityProbe::succeeded, this, [this, probe] {
+        if (probe == m_monitorProbe) {
+            monitorProbeFinished(true);
+        }
+    });
+    connect(probe, &ConnectivityProbe::failed, this, [this, probe] {
+        if (probe == m_monitorProbe) {
+            monitorProbeFinished(false);
+        }
+    });
+}
+
+void ConnectivityBackend::monitorProbeFinished(bool online)
+{
+    m_monitorProbe = nullptr;
+
+    if (online && m_monitorOnline) {
+        m_monitorInterval = qMin(m_monitorInterval * 2, MaximumMonitorInterval);
+    } else {
+        m_monitorInterval = MinimumMonitorInterval;
+    }
+    m_monitorOnline = online;
+    startMonitorTimer();
+
+    emit monitorVerdict(online);
+}
+
+void ConnectivityBackend::addStallWatcher(QObject *client, const ProbeParameters &parameters)
+{
+    for (Monitor &watcher : m_stallWatchers) {
+        if (watcher.client == client) {
+            watcher.parameters = parameters;
+            return;
+        }
+    }
+
+    Monitor watcher;
+    watcher.client = client;
+    watcher.parameters = parameters;
+    m_stallWatchers.append(watcher);
+    updateStallSampling();
+}
+
+void ConnectivityBackend::removeStallWatcher(QObject *client)
+{
+    for (int i = 0; i < m_stallWatchers.count(); ++i) {
+        if (m_stallWatchers.at(i).client == client) {
+            m_stallWatchers.removeAt(i);
+            break;
+        }
+    }
+
+    if (m_stallWatchers.isEmpty() && m_monitors.isEmpty() && m_linkWatchers.isEmpty() && m_monitorProbe) {
+        ConnectivityProbe *probe = m_monitorProbe;
+        m_monitorProbe = nullptr;
+        releaseProbe(probe);
+    }
+    updateStallSampling();
+}
+
+/*
+    Samples only while there is a usable default route with a known
+    interface, starting from a fresh baseline whenever that changes.
+*/
+void ConnectivityBackend::updateStallSampling()
+{
+    QString interface;
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (!m_stallWatchers.isEmpty() && backgroundWorkAllowed() && defaultRoute
+            && (defaultRoute->serviceState() == NetworkService::ReadyState
+                || defaultRoute->serviceState() == NetworkService::OnlineState)) {
+        interface = defaultRouteInterface();
+    }
+
+    if (interface.isEmpty()) {
+        m_stallTimer.stop();
+        m_stallInterface.clear();
+        return;
+    }
+
+    if (interface != m_stallInterface || !m_stallTimer.isActive()) {
+        m_stallInterface = interface;
+        m_stallRxFlatSince.invalidate();
+        m_stalled = false;
+        sampleInterfaceCounters();
+        m_stallTimer.start(StallSampleInterval);
+    }
+}
+
+void ConnectivityBackend::sampleInterfaceCounters()
+{
+    quint64 rxPackets = 0;
+    quint64 txPackets = 0;
+    if (!readInterfaceCounter(m_stallInterface, "rx_packets", &rxPackets)
+            || !readInterfaceCounter(m_stallInterface, "tx_packets", &txPackets)) {
+        // e.g. the interface went away, a route change follows.
+        m_stallRxFlatSince.invalidate();
+        return;
+    }
+
+    if (!m_stallRxFlatSince.isValid() || rxPackets != m_stallRxPackets) {
+        m_stallRxPackets = rxPackets;
+        m_stallTxPackets = txPackets;
+        m_stallRxFlatSince.start();
+        m_stalled = false;
+        return;
+    }
+
+    // only sending into a link that answers nothing, idle links are fine.
+    if (!m_stalled && txPackets > m_stallTxPackets && m_stallRxFlatSince.hasExpired(StallWindow)) {
+        m_stalled = true;
+        emit stallDetected();
+        if (!m_stallWatchers.isEmpty()) {
+            startVerificationProbe(m_stallWatchers.first().parameters);
+        }
+    }
+}
+
+QString ConnectivityBackend::defaultRouteInterface() const
+{
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    return defaultRoute ? defaultRoute->ethernet().value(QStringLiteral("Interface")).toString()
+                        : QString();
+}
+
+QVariantMap ConnectivityBackend::defaultRouteInfo() const
+{
+    QVariantMap info;
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (defaultRoute && !defaultRoute->path().isEmpty()) {
+        info.insert(QStringLiteral("service"), defaultRoute->path());
+        info.insert(QStringLiteral("name"), defaultRoute->name());
+        info.insert(QStringLiteral("technology"), defaultRoute->type());
+        info.insert(QStringLiteral("interface"), defaultRouteInterface());
+    }
+    return info;
+}
+
+bool ConnectivityBackend::verify(const ProbeParameters &parameters)
+{
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    if (m_monitorProbe && (!defaultRoute || defaultRoute->path() != m_monitorProbeService)) {
+        // started on another route, its verdict tells nothing about this one.
+        ConnectivityProbe *probe = m_monitorProbe;
+        m_monitorProbe = nullptr;
+        releaseProbe(probe);
+    }
+
+    startVerificationProbe(parameters);
+    return m_monitorProbe;
+}
+
+void ConnectivityBackend::setWarmUpHosts(QObject *client, const QStringList &hosts)
+{
+    QStringList added = hosts;
+    for (auto it = m_warmUpHosts.constBegin(); it != m_warmUpHosts.constEnd(); ++it) {
+        for (const QString &host : it.value()) {
+            added.removeAll(host);
+        }
+    }
+
+    if (hosts.isEmpty()) {
+        m_warmUpHosts.remove(client);
+    } else {
+        m_warmUpHosts.insert(client, hosts);
+    }
+
+    // a route is already up, no need to wait for the next one.
+    if (m_routeUsable) {
+        warmUp(added);
+    }
+}
+
+QMap<QString, ResolverStatistics> ConnectivityBackend::resolverStatistics() const
+{
+    return m_resolverStatistics;
+}
+
+void ConnectivityBackend::updateWarmUp(bool routeChanged)
+{
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    const bool usable = defaultRoute && (defaultRoute->serviceState() == NetworkService::ReadyState
+                                         || defaultRoute->serviceState() == NetworkService::OnlineState);
+    const bool becameUsable = usable && (!m_routeUsable || routeChanged);
+    m_routeUsable = usable;
+
+    if (!becameUsable && !(routeChanged && !m_warmUps.isEmpty())) {
+        return;
+    }
+
+    // lookups started on another route would be misattributed.
+    for (auto it = m_warmUps.constBegin(); it != m_warmUps.constEnd(); ++it) {
+        QHostInfo::abortHostLookup(it.key());
+    }
+    m_warmUps.clear();
+
+    if (becameUsable) {
+        QStringList hosts;
+        for (auto it = m_warmUpHosts.constBegin(); it != m_warmUpHosts.constEnd(); ++it) {
+            hosts.append(it.value());
+        }
+        hosts.removeDuplicates();
+        warmUp(hosts);
+    }
+}
+
+/*
+    Resolving fills the resolver caches, connman's DNS proxy and Qt's own
+    host cache that network access managers use, so that the first request
+    of each application after a network change does not pay for it.
+*/
+void ConnectivityBackend::warmUp(const QStringList &hosts)
+{
+    const QString interface = defaultRouteInterface();
+    for (const QString &host : hosts) {
+        bool pending = false;
+        for (const WarmUp &warmUp : m_warmUps) {
+            if (warmUp.host == host) {
+                pending = true;
+                break;
+            }
+        }
+        if (pending || host.isEmpty()) {
+            continue;
+        }
+
+        WarmUp warmUp;
+        warmUp.host = host;
+        warmUp.interface = interface;
+        warmUp.timer.start();
+        const int id = QHostInfo::lookupHost(host, this, SLOT(hostWarmedUp(QHostInfo)));
+        m_warmUps.insert(id, warmUp);
+    }
+}
+
+void ConnectivityBackend::hostWarmedUp(const QHostInfo &info)
+{
+    auto it = m_warmUps.find(info.lookupId());
+    if (it == m_warmUps.end()) {
+        return;
+    }
+
+    const WarmUp warmUp = it.value();
+    m_warmUps.erase(it);
+    recordResolverLatency(warmUp.interface, warmUp.timer.elapsed(), info.error() != QHostInfo::NoError);
+}
+
+void ConnectivityBackend::recordResolverLatency(const QString &interface, int milliseconds, bool failed)
+{
+    if (interface.isEmpty()) {
+        return;
+    }
+
+    ResolverStatistics &statistics = m_resolverStatistics[interface];
+    if (failed) {
+        ++statistics.failures;
+    } else {
+        statistics.latency.add(milliseconds);
+    }
+}
+
+void ConnectivityBackend::addLinkWatcher(QObject *client, const ProbeParameters &parameters)
+{
+    for (Monitor &watcher : m_linkWatchers) {
+        if (watcher.client == client) {
+            watcher.parameters = parameters;
+            return;
+        }
+    }
+
+    Monitor watcher;
+    watcher.client = client;
+    watcher.parameters = parameters;
+    m_linkWatchers.append(watcher);
+
+    if (!m_linkWatcher) {
+        m_linkWatcher = new LinkWatcher(this);
+        if (!m_linkWatcher->isValid()) {
+            // the constructor told why, the next client tries again.
+            qWarning() << "Unable to watch links, link loss is only noticed by probes";
+            delete m_linkWatcher;
+            m_linkWatcher = nullptr;
+            return;
+        }
+        connect(m_linkWatcher, &LinkWatcher::carrierChanged,
+                this, &ConnectivityBackend::handleCarrierChanged);
+        connect(m_linkWatcher, &LinkWatcher::addressesChanged,
+                this, &ConnectivityBackend::handleAddressesChanged);
+    }
+}
+
+void ConnectivityBackend::removeLinkWatcher(QObject *client)
+{
+    for (int i = 0; i < m_linkWatchers.count(); ++i) {
+        if (m_linkWatchers.at(i).client == client) {
+            m_linkWatchers.removeAt(i);
+            break;
+        }
+    }
+
+    if (m_linkWatchers.isEmpty()) {
+        if (m_linkWatcher) {
+            // the last client may be going away from a handler of its
+            // signals, emitted while it is still reading the socket.
+            m_linkWatcher->disconnect(this);
+            m_linkWatcher->deleteLater();
+            m_linkWatcher = nullptr;
+        }
+        if (m_monitorProbe && m_monitors.isEmpty() && m_stallWatchers.isEmpty()) {
+            ConnectivityProbe *probe = m_monitorProbe;
+            m_monitorProbe = nullptr;
+            releaseProbe(probe);
+        }
+    }
+}
+
+void ConnectivityBackend::handleCarrierChanged(const QString &interface, bool carrier)
+{
+    if (interface != defaultRouteInterface()) {
+        return;
+    }
+
+    if (!carrier) {
+        emit linkLost();
+    } else {
+        // back before connman may even have noticed, see if it works.
+        verifyForLinkWatchers();
+    }
+}
+
+void ConnectivityBackend::handleAddressesChanged(const QString &interface)
+{
+    if (interface != defaultRouteInterface()) {
+        return;
+    }
+
+    // e.g. expiring IPv6 privacy addresses are routine, only losing the
+    // last usable address matters.
+    const bool addressed = hasUsableAddress(interface);
+    if (addressed != m_defaultRouteAddressed) {
+        m_defaultRouteAddressed = addressed;
+        if (addressed) {
+            verifyForLinkWatchers();
+        } else {
+            emit addressLost();
+        }
+    }
+}
+
+bool ConnectivityBackend::hasUsableAddress(const QString &interface) const
+{
+    const QHostAddress ipv4LinkLocal(QStringLiteral("169.254.0.0"));
+    const QHostAddress ipv6LinkLocal(QStringLiteral("fe80::"));
+    const QList<QNetworkAddressEntry> entries = QNetworkInterface::interfaceFromName(interface).addressEntries();
+    for (const QNetworkAddressEntry &entry : entries) {
+        const QHostAddress address = entry.ip();
+        if (!address.isLoopback()
+                && !address.isInSubnet(ipv4LinkLocal, 16)
+                && !address.isInSubnet(ipv6LinkLocal, 10)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConnectivityBackend::verifyForLinkWatchers()
+{
+    if (!m_linkWatchers.isEmpty()) {
+        startVerificationProbe(m_linkWatchers.first().parameters);
+    }
+}
+
+void ConnectivityBackend::determineStatusCheckUrls()
+{
+    if (m_statusCheckUrlsPending) {
+        return;
+    }
+
+    m_statusCheckUrlsPending = true;
+    QDBusConnection::systemBus().callWithCallback(
+            QDBusMessage::createMethodCall(QStringLiteral("net.connman"),
+                                           QStringLiteral("/"),
+                                           QStringLiteral("net.connman.Manager"),
+                                           QStringLiteral("GetProperties")),
+            this,
+            SLOT(getConnmanManagerProperties(QVariantMap)),
+            SLOT(getConnmanManagerPropertiesFailed(QDBusError)));
+}
+
+void ConnectivityBackend::getConnmanManagerProperties(const QVariantMap &props)
+{
+    m_statusCheckUrlsPending = false;
+    m_ipv4StatusCheckUrl = props.value(QStringLiteral("Ipv4StatusUrl")).toString();
+    m_ipv6StatusCheckUrl = props.value(QStringLiteral("Ipv6StatusUrl")).toString();
+
+    for (const PendingProbe &pending : m_probes) {
+        startProbe(pending.probe);
+    }
+}
+
+void ConnectivityBackend::getConnmanManagerPropertiesFailed(const QDBusError &error)
+{
+    qWarning() << "Unable to get connman manager properties:" << error.message();
+    m_statusCheckUrlsPending = false;
+
+    // the fallback urls, if any, can still decide.
+    for (const PendingProbe &pending : m_probes) {
+        startProbe(pending.probe);
+    }
+}
+
+ConnectivityProbe *ConnectivityBackend::acquireProbe(const ProbeParameters &parameters)
+{
+    // the verdict is only cached for the route it was measured on, and a
+    // probe still running on a previous route is not joined.
+    NetworkService *defaultRoute = m_netman->defaultRoute();
+    const QString servicePath = defaultRoute ? defaultRoute->path() : QString();
+
+    for (PendingProbe &pending : m_probes) {
+        if (pending.probe->parameters() == parameters && pending.servicePath == servicePath) {
+            ++pending.waiters;
+            return pending.probe;
+        }
+    }
+
+    ConnectivityProbe *probe = new ConnectivityProbe(m_networkAccessManager, parameters, this);
+    connect(probe, &ConnectivityProbe::measured,
+            this, &ConnectivityBackend::updateLinkQuality);
+    connect(probe, &ConnectivityProbe::succeeded, this, [this, probe] {
+        probeFinished(probe, true);
+    });
+    connect(probe, &ConnectivityProbe::failed, this, [this, probe] {
+        probeFinished(probe, false);
+    });
+
+    PendingProbe pending;
+    pending.probe = probe;
+    pending.waiters = 1;
+    pending.servicePath = servicePath;
+    pending.serviceState = defaultRoute ? defaultRoute->serviceState() : NetworkService::UnknownState;
+    m_probes.append(pending);
+
+    // otherwise started once connman has told us the status check urls.
+    if (!m_statusCheckUrlsPending) {
+        startProbe(probe);
+    }
+
+    return probe;
+}
+
+void ConnectivityBackend::releaseProbe(ConnectivityProbe *probe)
+{
+    for (int i = 0; i < m_probes.count(); ++i) {
+        if (m_probes.at(i).probe == probe) {
+            if (--m_probes[i].waiters == 0) {
+                m_probes.removeAt(i);
+                probe->abort();
+                probe->deleteLater();
+            }
+            return;
+        }
+    }
+}
+
+void ConnectivityBackend::startProbe(ConnectivityProbe *probe)
+{
+    if (probe->isRunning()) {
+        return;
+    }
+
+    // Race the IPv6 and IPv4 status urls, preferring IPv6 as Happy Eyeballs
+    // does, followed by any configured fallbacks.  On IPv6-only networks
+    // the IPv4 probe can never answer, and on IPv4-only ones the IPv6 probe
+    // fails fast, so the first conclusive answer decides.
+    QList<QUrl> urls;
+    const QStringList candidates = QStringList()
+            << m_ipv6StatusCheckUrl
+            << m_ipv4StatusCheckUrl
+            << probe->parameters().fallbackUrls;
+    for (const QString &candidate : candidates) {
+        const QUrl url(candidate);
+        if (url.isValid() && !url.isRelative() && !urls.contains(url)) {
+            urls.append(url);
+        }
+    }
+
+    const QList<QUrl> connmanUrls = QList<QUrl>()
+            << QUrl(m_ipv6StatusCheckUrl)
+            << QUrl(m_ipv4StatusCheckUrl);
+
+    probe->start(urls, connmanUrls);
+}
+
+void ConnectivityBackend::probeFinished(ConnectivityProbe *probe, bool online)
+{
+    // Called before the waiting helpers are notified, so the probe
+    // must outlive this signal emission.
+    for (int i = 0; i < m_probes.count(); ++i) {
+        const PendingProbe pending = m_probes.at(i);
+        if (pending.probe == probe) {
+            m_probes.removeAt(i);
+
+            // Only success is remembered. A failure may be fixed at any
+            // moment, e.g. by logging in to a portal, and is probed again.
+            NetworkService *defaultRoute = m_netman->defaultRoute();
+            if (!online) {
+                if (m_verdictTimer.isValid()) {
+                    clearVerdict();
+                    updateCapabilities();
+                }
+            } else if (defaultRoute && !pending.servicePath.isEmpty()
+                    && defaultRoute->path() == pending.servicePath
+                    && defaultRoute->serviceState() == pending.serviceState) {
+                m_verdictServicePath = pending.servicePath;
+                m_verdictServiceState = pending.serviceState;
+                m_verdictTimer.start();
+                updateCapabilities();
+            }
+            break;
+        }
+    }
+    probe->deleteLater();
+}
+
+}
@@ -0,0 +1,279 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_CONNECTIVITYBACKEND_P_H
+#define NEMO_CONNECTIVITYBACKEND_P_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+QT_BEGIN_NAMESPACE
+class QDBusError;
+class QHostInfo;
+class QNetworkAccessManager;
+QT_END_NAMESPACE
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <connman-qt6/networkservice.h>
+#else
+#include <connman-qt5/networkservice.h>
+#endif
+
+#include "connectivityprobe_p.h"
+#include "latencyhistogram.h"
+#include "linkquality.h"
+#include "networkrequirement.h"
+
+class NetworkManager;
+
+namespace Nemo {
+
+class LinkWatcher;
+
+// What the current default route offers, as requirements see it.
+struct NetworkCapabilities
+{
+    NetworkCapabilities();
+
+    bool operator==(const NetworkCapabilities &other) const;
+    bool operator!=(const NetworkCapabilities &other) const;
+    bool satisfies(const NetworkRequirement &requirement) const;
+
+    bool online;
+    bool metered;
+    bool roaming;
+    bool vpn;
+    int bandwidth; // kbit/s, -1 if not measured
+    int rtt; // ms, -1 if not measured
+};
+
+struct ResolverStatistics
+{
+    ResolverStatistics() : failures(0) {}
+
+    LatencyHistogram latency;
+    int failures;
+};
+
+/*
+    Process wide state shared by all ConnectionHelper instances: the connman
+    subscriptions, the status check urls published by connman and the
+    network access manager used for canary requests. Concurrent canary
+    requests with the same fallback urls are coalesced into a single probe.
+
+    While any helper monitors connectivity, the backend also re-verifies it
+    in the background, one probe for all of them. While any helper watches
+    for stalls, the traffic counters of the default route's interface are
+    sampled and a probe is only sent once the link looks stalled. While any
+    helper watches the link, rtnetlink reports carrier and address loss on
+    the default route's interface ahead of connman.
+
+    Background checks are paused while the display is off or the
+    application is not active.
+*/
+class ConnectivityBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~ConnectivityBackend();
+
+    static QSharedPointer<ConnectivityBackend> sharedInstance();
+
+    QSharedPointer<NetworkManager> networkManager() const;
+    QNetworkAccessManager *networkAccessManager() const;
+
+    // False until connman's presence on the system bus is known.
+    bool ready() const;
+    bool connmanAvailable() const;
+
+    // Returns the in-flight probe for the given parameters, starting one
+    // if needed. Every acquired probe must be released unless it finished.
+    ConnectivityProbe *acquireProbe(const ProbeParameters &parameters);
+    void releaseProbe(ConnectivityProbe *probe);
+
+    // Returns true if a probe on the current default route, in its
+    // current state, succeeded less than maxAge milliseconds ago.
+    bool recentlyOnline(int maxAge) const;
+
+    LinkQuality linkQuality() const;
+
+    // Time-to-outcome of connection attempts, by kind of attempt.
+    void recordLatency(const QString &key, qint64 milliseconds);
+    QMap<QString, LatencyHistogram> latencyHistograms() const;
+    void resetLatencyHistograms();
+
+    // The parameters of the earliest monitoring client are used.
+    void addMonitor(QObject *client, const ProbeParameters &parameters);
+    void removeMonitor(QObject *client);
+
+    void addStallWatcher(QObject *client, const ProbeParameters &parameters);
+    void removeStallWatcher(QObject *client);
+
+    void addLinkWatcher(QObject *client, const ProbeParameters &parameters);
+    void removeLinkWatcher(QObject *client);
+
+    // Checks the current route once, reported through monitorVerdict().
+    // False if no check of the current route is under way, e.g. as the
+    // route is not usable.
+    bool verify(const ProbeParameters &parameters);
+
+    // Host names resolved ahead of use whenever a route becomes usable,
+    // and how long resolving takes, by interface.
+    void setWarmUpHosts(QObject *client, const QStringList &hosts);
+    QMap<QString, ResolverStatistics> resolverStatistics() const;
+
+    NetworkCapabilities capabilities() const;
+
+Q_SIGNALS:
+    void readyChanged();
+    void connmanAvailableChanged(bool available);
+    void networkStateChanged(const QString &state);
+    void linkQualityChanged();
+    void monitorVerdict(bool online);
+    void stallDetected();
+    void linkLost();
+    void addressLost();
+    void handover(const QVariantMap &previous, const QVariantMap &current);
+    void capabilitiesChanged();
+
+private Q_SLOTS:
+    void getConnmanManagerProperties(const QVariantMap &props);
+    void getConnmanManagerPropertiesFailed(const QDBusError &error);
+    void handleNetworkStateChanged(const QString &state);
+    void handleDefaultRouteChanged();
+    void clearVerdict();
+    void updateLinkQuality(const Nemo::ProbeTiming &timing, int rttSample, bool newTlsConnection);
+    void runMonitorProbe();
+    void sampleInterfaceCounters();
+    void handleCarrierChanged(const QString &interface, bool carrier);
+    void handleAddressesChanged(const QString &interface);
+    void hostWarmedUp(const QHostInfo &info);
+    void recordThroughput(qint64 bytes, qint64 milliseconds);
+    void handleDisplayStatus(const QString &status);
+    void handleApplicationStateChanged(Qt::ApplicationState state);
+    void updateCapabilities();
+
+private:
+    ConnectivityBackend();
+
+    void determineConnmanAvailable();
+    void setConnmanAvailable(bool available);
+    void determineStatusCheckUrls();
+    void startProbe(ConnectivityProbe *probe);
+    void probeFinished(ConnectivityProbe *probe, bool online);
+    void restartMonitoring();
+    void startVerificationProbe(const ProbeParameters &parameters);
+    void monitorProbeFinished(bool online);
+    void updateStallSampling();
+    QString defaultRouteInterface() const;
+    QVariantMap defaultRouteInfo() const;
+    bool hasUsableAddress(const QString &interface) const;
+    void verifyForLinkWatchers();
+    bool backgroundWorkAllowed() const;
+    void setBackgroundWorkAllowed(bool displayOn, bool applicationActive);
+    void startMonitorTimer();
+    void updateWarmUp(bool routeChanged);
+    void warmUp(const QStringList &hosts);
+    void recordResolverLatency(const QString &interface, int milliseconds, bool failed);
+    NetworkService *transportService() const;
+    void updateCapabilityWatch();
+    NetworkCapabilities currentCapabilities() const;
+
+    struct PendingProbe {
+        ConnectivityProbe *probe;
+        int waiters;
+        QString servicePath;
+        NetworkService::ServiceState serviceState;
+    };
+
+    struct Monitor {
+        QObject *client;
+        ProbeParameters parameters;
+    };
+
+    QSharedPointer<NetworkManager> m_netman;
+    QNetworkAccessManager *m_networkAccessManager;
+    QList<PendingProbe> m_probes;
+    QString m_ipv4StatusCheckUrl;
+    QString m_ipv6StatusCheckUrl;
+    QString m_verdictServicePath;
+    NetworkService::ServiceState m_verdictServiceState;
+    QElapsedTimer m_verdictTimer;
+    LinkQuality m_linkQuality;
+    NetworkCapabilities m_capabilities;
+    QMap<QString, LatencyHistogram> m_latencyHistograms;
+    qreal m_smoothedRtt;
+    qreal m_rttVariation;
+    bool m_ready;
+    bool m_connmanAvailable;
+    bool m_statusCheckUrlsPending;
+    QList<Monitor> m_monitors;
+    QTimer m_monitorTimer;
+    ConnectivityProbe *m_monitorProbe;
+    QString m_monitorProbeService;
+    int m_monitorInterval;
+    bool m_monitorOnline;
+    QList<Monitor> m_stallWatchers;
+    QTimer m_stallTimer;
+    QString m_stallInterface;
+    quint64 m_stallRxPackets;
+    quint64 m_stallTxPackets;
+    QElapsedTimer m_stallRxFlatSince;
+    bool m_stalled;
+    QList<Monitor> m_linkWatchers;
+    LinkWatcher *m_linkWatcher;
+    bool m_defaultRouteAddressed;
+    QVariantMap m_defaultRouteInfo;
+
+    struct WarmUp {
+        QString host;
+        QString interface;
+        QElapsedTimer timer;
+    };
+
+    QHash<QObject *, QStringList> m_warmUpHosts;
+    QHash<int, WarmUp> m_warmUps; // by lookup id
+    QMap<QString, ResolverStatistics> m_resolverStatistics;
+    bool m_routeUsable;
+    QPointer<NetworkService> m_capabilityRoute;
+    bool m_displayOn;
+    bool m_applicationActive;
+};
+
+}
+
+#endif
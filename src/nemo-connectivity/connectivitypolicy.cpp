@@ -0,0 +1,326 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "connectivitypolicy.h"
+
+namespace {
+
+const int DefaultExplicitTimeout = 300000; // 5 min
+const int DefaultImplicitTimeout = 5000; // 5 sec
+const int DefaultMaximumOfflineDelay = 1000; // 1 sec
+const int DefaultRetryInitialDelay = 2000; // 2 sec
+const int DefaultRetryMaximumDelay = 300000; // 5 min
+
+}
+
+namespace Nemo {
+
+class ConnectivityPolicyPrivate
+{
+public:
+    ConnectivityPolicyPrivate();
+
+    int explicitTimeout;
+    int implicitTimeout;
+    ConnectivityPolicy::ProbeMethod probeMethod;
+    QList<int> expectedStatusCodes;
+    QString expectedBody;
+    int probeRetries;
+    int stateDebounceWindow;
+    int maximumOfflineDelay;
+    bool prewarmConnectionSelector;
+    int retryAttempts;
+    int retryInitialDelay;
+    int retryMaximumDelay;
+};
+
+ConnectivityPolicyPrivate::ConnectivityPolicyPrivate()
+    : explicitTimeout(DefaultExplicitTimeout)
+    , implicitTimeout(DefaultImplicitTimeout)
+    , probeMethod(ConnectivityPolicy::Head)
+    , probeRetries(0)
+    , stateDebounceWindow(0)
+    , maximumOfflineDelay(DefaultMaximumOfflineDelay)
+    , prewarmConnectionSelector(false)
+    , retryAttempts(0)
+    , retryInitialDelay(DefaultRetryInitialDelay)
+    , retryMaximumDelay(DefaultRetryMaximumDelay)
+{
+}
+
+/*
+    Describes how a ConnectionHelper decides whether the network is usable.
+    A single policy can be shared by several helpers; helpers without a
+    policy use the defaults below.
+*/
+ConnectivityPolicy::ConnectivityPolicy(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new ConnectivityPolicyPrivate)
+{
+}
+
+ConnectivityPolicy::~ConnectivityPolicy()
+{
+    delete d_ptr;
+    d_ptr = nullptr;
+}
+
+/*
+    Time in milliseconds allowed for attemptToConnectNetwork(), including
+    the time the user spends in the connection selector. Defaults to 5 min.
+*/
+int ConnectivityPolicy::explicitTimeout() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->explicitTimeout;
+}
+
+void ConnectivityPolicy::setExplicitTimeout(int timeout)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->explicitTimeout != timeout) {
+        d->explicitTimeout = timeout;
+        emit explicitTimeoutChanged();
+    }
+}
+
+/*
+    Time in milliseconds allowed for requestNetwork(). Defaults to 5 sec.
+*/
+int ConnectivityPolicy::implicitTimeout() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->implicitTimeout;
+}
+
+void ConnectivityPolicy::setImplicitTimeout(int timeout)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->implicitTimeout != timeout) {
+        d->implicitTimeout = timeout;
+        emit implicitTimeoutChanged();
+    }
+}
+
+/*
+    Request used for the canary check. ExpectNoContent sends a GET and
+    only accepts a 204 reply, which suits generate_204 style endpoints
+    given as fallback status urls.
+*/
+ConnectivityPolicy::ProbeMethod ConnectivityPolicy::probeMethod() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->probeMethod;
+}
+
+void ConnectivityPolicy::setProbeMethod(ProbeMethod method)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->probeMethod != method) {
+        d->probeMethod = method;
+        emit probeMethodChanged();
+    }
+}
+
+/*
+    HTTP status codes accepted as a successful canary reply. When empty,
+    any 2xx reply is accepted. Redirects and 511 replies always count as
+    a Captive Portal.
+*/
+QList<int> ConnectivityPolicy::expectedStatusCodes() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->expectedStatusCodes;
+}
+
+void ConnectivityPolicy::setExpectedStatusCodes(const QList<int> &codes)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->expectedStatusCodes != codes) {
+        d->expectedStatusCodes = codes;
+        emit expectedStatusCodesChanged();
+    }
+}
+
+/*
+    Body a Get canary reply must start with, e.g. "Success". Only that
+    many bytes are read before the reply is aborted. When empty, the
+    verdict is taken from the status code and headers alone.
+*/
+QString ConnectivityPolicy::expectedBody() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->expectedBody;
+}
+
+void ConnectivityPolicy::setExpectedBody(const QString &body)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->expectedBody != body) {
+        d->expectedBody = body;
+        emit expectedBodyChanged();
+    }
+}
+
+/*
+    How many times a failed canary check is repeated before the attempt
+    is given up, as long as the timeout allows. Defaults to none.
+*/
+int ConnectivityPolicy::probeRetries() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->probeRetries;
+}
+
+void ConnectivityPolicy::setProbeRetries(int retries)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->probeRetries != retries) {
+        d->probeRetries = retries;
+        emit probeRetriesChanged();
+    }
+}
+
+/*
+    Time in milliseconds network state changes are held back so that
+    short flaps, e.g. online -> ready -> online while roaming, result in
+    a single status change. Defaults to 0, which applies every change
+    immediately.
+*/
+int ConnectivityPolicy::stateDebounceWindow() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->stateDebounceWindow;
+}
+
+void ConnectivityPolicy::setStateDebounceWindow(int window)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->stateDebounceWindow != window) {
+        d->stateDebounceWindow = window;
+        emit stateDebounceWindowChanged();
+    }
+}
+
+/*
+    Upper bound in milliseconds for how long the debounce window may hold
+    back a transition to offline. Defaults to 1 sec.
+*/
+int ConnectivityPolicy::maximumOfflineDelay() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->maximumOfflineDelay;
+}
+
+void ConnectivityPolicy::setMaximumOfflineDelay(int delay)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->maximumOfflineDelay != delay) {
+        d->maximumOfflineDelay = delay;
+        emit maximumOfflineDelayChanged();
+    }
+}
+
+/*
+    Whether the connection selector service is started as soon as a helper
+    begins connecting, so that the dialog opens faster if it is needed.
+    Defaults to false.
+*/
+bool ConnectivityPolicy::prewarmConnectionSelector() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->prewarmConnectionSelector;
+}
+
+void ConnectivityPolicy::setPrewarmConnectionSelector(bool prewarm)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->prewarmConnectionSelector != prewarm) {
+        d->prewarmConnectionSelector = prewarm;
+        emit prewarmConnectionSelectorChanged();
+    }
+}
+
+/*
+    How many times a failed requestNetwork() is retried by the helper.
+    Defaults to 0, leaving retries to the caller.
+*/
+int ConnectivityPolicy::retryAttempts() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->retryAttempts;
+}
+
+void ConnectivityPolicy::setRetryAttempts(int attempts)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->retryAttempts != attempts) {
+        d->retryAttempts = attempts;
+        emit retryAttemptsChanged();
+    }
+}
+
+/*
+    Delay in milliseconds before the first retry. It doubles with each
+    further retry, and every delay is randomly shortened by up to half so
+    that helpers failing together do not retry together. Defaults to 2 sec.
+*/
+int ConnectivityPolicy::retryInitialDelay() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->retryInitialDelay;
+}
+
+void ConnectivityPolicy::setRetryInitialDelay(int delay)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->retryInitialDelay != delay) {
+        d->retryInitialDelay = delay;
+        emit retryInitialDelayChanged();
+    }
+}
+
+/*
+    Upper bound in milliseconds for the retry delay. Defaults to 5 min.
+*/
+int ConnectivityPolicy::retryMaximumDelay() const
+{
+    Q_D(const ConnectivityPolicy);
+    return d->retryMaximumDelay;
+}
+
+void ConnectivityPolicy::setRetryMaximumDelay(int delay)
+{
+    Q_D(ConnectivityPolicy);
+    if (d->retryMaximumDelay != delay) {
+        d->retryMaximumDelay = delay;
+        emit retryMaximumDelayChanged();
+    }
+}
+
+}
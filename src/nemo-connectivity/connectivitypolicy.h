@@ -0,0 +1,127 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_CONNECTIVITYPOLICY_H
+#define NEMO_CONNECTIVITYPOLICY_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+
+#include <nemo-connectivity/global.h>
+
+namespace Nemo {
+
+class ConnectivityPolicyPrivate;
+
+class NEMO_CONNECTIVITY_EXPORT ConnectivityPolicy : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int explicitTimeout READ explicitTimeout WRITE setExplicitTimeout NOTIFY explicitTimeoutChanged)
+    Q_PROPERTY(int implicitTimeout READ implicitTimeout WRITE setImplicitTimeout NOTIFY implicitTimeoutChanged)
+    Q_PROPERTY(ProbeMethod probeMethod READ probeMethod WRITE setProbeMethod NOTIFY probeMethodChanged)
+    Q_PROPERTY(QList<int> expectedStatusCodes READ expectedStatusCodes WRITE setExpectedStatusCodes NOTIFY expectedStatusCodesChanged)
+    Q_PROPERTY(QString expectedBody READ expectedBody WRITE setExpectedBody NOTIFY expectedBodyChanged)
+    Q_PROPERTY(int probeRetries READ probeRetries WRITE setProbeRetries NOTIFY probeRetriesChanged)
+    Q_PROPERTY(int stateDebounceWindow READ stateDebounceWindow WRITE setStateDebounceWindow NOTIFY stateDebounceWindowChanged)
+    Q_PROPERTY(int maximumOfflineDelay READ maximumOfflineDelay WRITE setMaximumOfflineDelay NOTIFY maximumOfflineDelayChanged)
+    Q_PROPERTY(bool prewarmConnectionSelector READ prewarmConnectionSelector WRITE setPrewarmConnectionSelector NOTIFY prewarmConnectionSelectorChanged)
+    Q_PROPERTY(int retryAttempts READ retryAttempts WRITE setRetryAttempts NOTIFY retryAttemptsChanged)
+    Q_PROPERTY(int retryInitialDelay READ retryInitialDelay WRITE setRetryInitialDelay NOTIFY retryInitialDelayChanged)
+    Q_PROPERTY(int retryMaximumDelay READ retryMaximumDelay WRITE setRetryMaximumDelay NOTIFY retryMaximumDelayChanged)
+
+public:
+    explicit ConnectivityPolicy(QObject *parent = nullptr);
+    ~ConnectivityPolicy();
+
+    enum ProbeMethod {
+        Head,
+        Get,
+        ExpectNoContent
+    };
+    Q_ENUM(ProbeMethod)
+
+    int explicitTimeout() const;
+    void setExplicitTimeout(int timeout);
+
+    int implicitTimeout() const;
+    void setImplicitTimeout(int timeout);
+
+    ProbeMethod probeMethod() const;
+    void setProbeMethod(ProbeMethod method);
+
+    QList<int> expectedStatusCodes() const;
+    void setExpectedStatusCodes(const QList<int> &codes);
+
+    QString expectedBody() const;
+    void setExpectedBody(const QString &body);
+
+    int probeRetries() const;
+    void setProbeRetries(int retries);
+
+    int stateDebounceWindow() const;
+    void setStateDebounceWindow(int window);
+
+    int maximumOfflineDelay() const;
+    void setMaximumOfflineDelay(int delay);
+
+    bool prewarmConnectionSelector() const;
+    void setPrewarmConnectionSelector(bool prewarm);
+
+    int retryAttempts() const;
+    void setRetryAttempts(int attempts);
+
+    int retryInitialDelay() const;
+    void setRetryInitialDelay(int delay);
+
+    int retryMaximumDelay() const;
+    void setRetryMaximumDelay(int delay);
+
+Q_SIGNALS:
+    void explicitTimeoutChanged();
+    void implicitTimeoutChanged();
+    void probeMethodChanged();
+    void expectedStatusCodesChanged();
+    void expectedBodyChanged();
+    void probeRetriesChanged();
+    void stateDebounceWindowChanged();
+    void maximumOfflineDelayChanged();
+    void prewarmConnectionSelectorChanged();
+    void retryAttemptsChanged();
+    void retryInitialDelayChanged();
+    void retryMaximumDelayChanged();
+
+private:
+    ConnectivityPolicyPrivate *d_ptr;
+    Q_DISABLE_COPY(ConnectivityPolicy)
+    Q_DECLARE_PRIVATE(ConnectivityPolicy)
+};
+
+}
+
+#endif
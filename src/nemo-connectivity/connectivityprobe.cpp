@@ -0,0 +1,472 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "connectivityprobe_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QTimer>
+
+namespace {
+
+// Delay before racing the next status check url, as recommended for
+// Happy Eyeballs connection attempts in RFC 8305.
+const int AttemptDelay = 250;
+
+// How long a deciding reply may take to complete before its connection
+// is given up on rather than kept for reuse.
+const int KeepAliveGrace = 2000;
+
+// How long the network access manager keeps an idle connection for reuse.
+const int IdleConnectionExpiry = 120000;
+
+// Set by connman's status check servers on their replies.
+const QByteArray ConnmanStatusHeader("X-ConnMan-Status");
+const QByteArray ConnmanStatusOnline("online");
+
+// When a connection to each status check server was last kept alive.
+QHash<QString, QElapsedTimer> keptAliveConnections;
+
+QString connectionKey(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemoveUserInfo | QUrl::RemovePath | QUrl::RemoveQuery
+                        | QUrl::RemoveFragment).toString();
+}
+
+bool hasKeptAliveConnection(const QUrl &url)
+{
+    const auto it = keptAliveConnections.constFind(connectionKey(url));
+    return it != keptAliveConnections.constEnd() && !it->hasExpired(IdleConnectionExpiry);
+}
+
+}
+
+namespace Nemo {
+
+ProbeParameters::ProbeParameters()
+    : method(ConnectivityPolicy::Head)
+{
+}
+
+bool ProbeParameters::operator==(const ProbeParameters &other) const
+{
+    return fallbackUrls == other.fallbackUrls
+            && method == other.method
+            && expectedStatusCodes == other.expectedStatusCodes
+            && expectedBody == other.expectedBody;
+}
+
+ConnectivityProbe::Attempt::Attempt()
+    : lookupId(-1)
+    , dnsLookup(-1)
+    , connectStarted(-1)
+    , encrypted(-1)
+    , requestSent(-1)
+    , firstByte(-1)
+{
+}
+
+ConnectivityProbe::ConnectivityProbe(QNetworkAccessManager *manager, const ProbeParameters &parameters,
+                                     QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_parameters(parameters)
+    , m_nextAttempt(0)
+    , m_running(false)
+{
+    m_attemptDelayTimer.setSingleShot(true);
+    connect(&m_attemptDelayTimer, &QTimer::timeout,
+            this, &ConnectivityProbe::startNextAttempt);
+}
+
+ConnectivityProbe::~ConnectivityProbe()
+{
+    abortReplies();
+}
+
+void ConnectivityProbe::start(const QList<QUrl> &urls, const QList<QUrl> &connmanUrls)
+{
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_urls = urls;
+    m_connmanUrls = connmanUrls;
+    m_nextAttempt = 0;
+
+    // the first attempt is started from the event loop so that the
+    // outcome is always reported asynchronously.
+    m_attemptDelayTimer.start(0);
+}
+
+void ConnectivityProbe::abort()
+{
+    m_running = false;
+    m_attemptDelayTimer.stop();
+    abortReplies();
+}
+
+bool ConnectivityProbe::isRunning() const
+{
+    return m_running;
+}
+
+ProbeParameters ConnectivityProbe::parameters() const
+{
+    return m_parameters;
+}
+
+void ConnectivityProbe::startNextAttempt()
+{
+    while (m_running && m_nextAttempt < m_urls.count()) {
+        // Testing network connectivity, always load from network.
+        QNetworkRequest request(m_urls.at(m_nextAttempt++));
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                             QNetworkRequest::AlwaysNetwork);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+        // a redirect is the answer, following it would hide a Captive Portal.
+        request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                             QNetworkRequest::ManualRedirectPolicy);
+#endif
+        Attempt attempt;
+        attempt.timer.start();
+
+        // Resolve the host alongside the request. The network access manager
+        // waits for the same lookup rather than making its own, so this only
+        // tells how long it took.
+        const QString host = request.url().host();
+        if (!QHostAddress(host).isNull()) {
+            attempt.dnsLookup = 0;
+        } else {
+            attempt.lookupId = QHostInfo::lookupHost(host, this, SLOT(hostLookedUp(QHostInfo)));
+        }
+
+        QNetworkReply *reply = m_parameters.method == ConnectivityPolicy::Head
+                ? m_manager->head(request)
+                : m_manager->get(request);
+        if (!reply) {
+            if (attempt.lookupId != -1) {
+                QHostInfo::abortHostLookup(attempt.lookupId);
+            }
+            continue;
+        }
+
+        m_replies.append(reply);
+        m_attempts.insert(reply, attempt);
+        if (attempt.lookupId != -1) {
+            m_lookups.insert(attempt.lookupId, reply);
+        }
+
+        // Decide as soon as the headers, or the few bytes of body we
+        // expect, are in rather than waiting for the whole reply.
+        connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply] {
+            Attempt &attempt = m_attempts[reply];
+            if (attempt.firstByte < 0) {
+                attempt.firstByte = attempt.timer.elapsed();
+            }
+            conclude(reply, headerVerdict(reply));
+        });
+        connect(reply, &QNetworkReply::readyRead, this, [this, reply] {
+            conclude(reply, bodyVerdict(reply));
+        });
+#ifndef QT_NO_SSL
+        connect(reply, &QNetworkReply::encrypted, this, [this, reply] {
+            m_attempts[reply].encrypted = m_attempts[reply].timer.elapsed();
+        });
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+        connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, reply] {
+            m_attempts[reply].connectStarted = m_attempts[reply].timer.elapsed();
+        });
+        connect(reply, &QNetworkReply::requestSent, this, [this, reply] {
+            m_attempts[reply].requestSent = m_attempts[reply].timer.elapsed();
+        });
+#endif
+        connect(reply, &QNetworkReply::finished, this, [this, reply] {
+            attemptFinished(reply);
+        });
+
+        if (m_nextAttempt < m_urls.count()) {
+            m_attemptDelayTimer.start(AttemptDelay);
+        }
+        return;
+    }
+
+    if (m_running && m_replies.isEmpty()) {
+        finish(false);
+    }
+}
+
+void ConnectivityProbe::attemptFinished(QNetworkReply *reply)
+{
+    m_replies.removeOne(reply);
+    reply->deleteLater();
+
+    if (!m_running) {
+        forgetAttempt(reply);
+        return;
+    }
+
+    Verdict verdict = Inconclusive;
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) {
+        verdict = headerVerdict(reply);
+        if (verdict == Undecided) {
+            verdict = bodyVerdict(reply);
+        }
+        if (verdict == Undecided) {
+            // shorter than the expected body.
+            verdict = CaptivePortal;
+        }
+    }
+
+    // An attempt may fail without telling anything, e.g. when the address
+    // family of this url is not routable, in which case the remaining urls
+    // decide.
+    if (verdict != Inconclusive) {
+        conclude(reply, verdict);
+        forgetAttempt(reply);
+        return;
+    }
+
+    forgetAttempt(reply);
+    if (m_nextAttempt < m_urls.count()) {
+        // don't wait for the attempt delay, race the next url right away.
+        m_attemptDelayTimer.stop();
+        startNextAttempt();
+    } else if (m_replies.isEmpty()) {
+        finish(false);
+    }
+}
+
+ConnectivityProbe::Verdict ConnectivityProbe::headerVerdict(QNetworkReply *reply) const
+{
+    const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    if (!status.isValid()) {
+        return Undecided;
+    }
+
+    const int statusCode = status.toInt();
+    if ((statusCode >= 300 && statusCode < 400) || statusCode == 511) {
+        // redirected to a login page, or Network Authentication Required.
+        return CaptivePortal;
+    } else if (statusCode < 200 || statusCode >= 300) {
+        // the status check server itself is having trouble.
+        return Inconclusive;
+    }
+
+    // connman's own urls answer with a status and body of their own, so
+    // only the header they set tells. Without it the url alone fails and
+    // the other urls decide.
+    if (m_connmanUrls.contains(reply->request().url())) {
+        if (!reply->hasRawHeader(ConnmanStatusHeader)) {
+            return Inconclusive;
+        }
+        return reply->rawHeader(ConnmanStatusHeader) == ConnmanStatusOnline ? Online : CaptivePortal;
+    }
+
+    if (!isExpectedStatusCode(statusCode)) {
+        // e.g. a portal answering 200 where 204 was expected.
+        return CaptivePortal;
+    }
+
+    return expectsBody() ? Undecided : Online;
+}
+
+ConnectivityProbe::Verdict ConnectivityProbe::bodyVerdict(QNetworkReply *reply)
+{
+    if (!expectsBody() || headerVerdict(reply) != Undecided) {
+        return Undecided;
+    }
+
+    const QByteArray &expected = m_parameters.expectedBody;
+    QByteArray &body = m_attempts[reply].body;
+    body.append(reply->read(expected.size() - body.size()));
+
+    if (!expected.startsWith(body)) {
+        return CaptivePortal;
+    } else if (body.size() == expected.size()) {
+        return Online;
+    }
+    return Undecided;
+}
+
+bool ConnectivityProbe::isExpectedStatusCode(int statusCode) const
+{
+    if (m_parameters.method == ConnectivityPolicy::ExpectNoContent) {
+        return statusCode == 204;
+    }
+
+    return m_parameters.expectedStatusCodes.isEmpty()
+            || m_parameters.expectedStatusCodes.contains(statusCode);
+}
+
+bool ConnectivityProbe::expectsBody() const
+{
+    return m_parameters.method == ConnectivityPolicy::Get && !m_parameters.expectedBody.isEmpty();
+}
+
+void ConnectivityProbe::conclude(QNetworkReply *reply, Verdict verdict)
+{
+    // Inconclusive attempts are left to finish, the other urls may answer.
+    if (!m_running || verdict == Undecided || verdict == Inconclusive) {
+        return;
+    }
+
+    reportTiming(reply);
+
+    // The connection a portal answered on is of no use.
+    if (verdict == Online) {
+        keepAlive(reply);
+    }
+
+    // Aborts the remaining replies, and a portal's deciding one, so no
+    // more bytes than needed are transferred.
+    finish(verdict == Online);
+}
+
+void ConnectivityProbe::reportTiming(QNetworkReply *reply)
+{
+    const Attempt attempt = m_attempts.value(reply);
+    if (attempt.firstByte < 0) {
+        return;
+    }
+
+    ProbeTiming timing;
+    timing.dnsLookup = attempt.dnsLookup;
+    timing.total = attempt.firstByte;
+
+    // When the connection became ready for the request, if observable.
+    // Qt 6.3 tells when the request was sent on a new and a reused
+    // connection alike, and when a new one started connecting.
+    qint64 ready = -1;
+    if (attempt.requestSent >= 0) {
+        ready = attempt.requestSent;
+        if (attempt.connectStarted >= 0) {
+            timing.connect = attempt.requestSent - attempt.connectStarted;
+        }
+    } else if (attempt.encrypted >= 0 && attempt.dnsLookup >= 0) {
+        ready = attempt.encrypted;
+        timing.connect = attempt.encrypted - attempt.dnsLookup;
+    }
+
+    // Once connected, the request and its reply headers take about one
+    // round trip. Otherwise the TCP handshake is in there too, which makes
+    // it about two on a new connection. A connection kept alive by an
+    // earlier probe may have been reused instead, which can't be told
+    // apart, so no sample is taken then.
+    int rttSample = -1;
+    if (ready >= 0) {
+        timing.firstByte = attempt.firstByte - ready;
+        rttSample = timing.firstByte;
+    } else {
+        timing.firstByte = attempt.firstByte - qMax<qint64>(attempt.dnsLookup, 0);
+        if (attempt.encrypted < 0 && !hasKeptAliveConnection(reply->request().url())) {
+            rttSample = timing.firstByte / 2;
+        }
+    }
+
+    emit measured(timing, rttSample, attempt.encrypted >= 0);
+}
+
+void ConnectivityProbe::hostLookedUp(const QHostInfo &info)
+{
+    QNetworkReply *reply = m_lookups.take(info.lookupId());
+    if (reply && m_attempts.contains(reply)) {
+        Attempt &attempt = m_attempts[reply];
+        attempt.dnsLookup = attempt.timer.elapsed();
+        attempt.lookupId = -1;
+    }
+}
+
+void ConnectivityProbe::forgetAttempt(QNetworkReply *reply)
+{
+    const Attempt attempt = m_attempts.take(reply);
+    if (attempt.lookupId != -1) {
+        m_lookups.remove(attempt.lookupId);
+        QHostInfo::abortHostLookup(attempt.lookupId);
+    }
+}
+
+/*
+    Aborting a reply closes its connection. An online reply has little or
+    no body left, so it is drained instead, after which the network access
+    manager keeps the connection, and any TLS session, for reuse.
+*/
+void ConnectivityProbe::keepAlive(QNetworkReply *reply)
+{
+    if (!m_replies.removeOne(reply)) {
+        return;
+    }
+    forgetAttempt(reply);
+    disconnect(reply, nullptr, this, nullptr);
+    keptAliveConnections[connectionKey(reply->request().url())].start();
+
+    if (reply->isFinished()) {
+        reply->deleteLater();
+        return;
+    }
+
+    connect(reply, &QNetworkReply::readyRead, reply, [reply] {
+        reply->readAll();
+    });
+    connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+    QTimer::singleShot(KeepAliveGrace, reply, [reply] {
+        reply->abort();
+    });
+}
+
+void ConnectivityProbe::finish(bool online)
+{
+    abort();
+
+    if (online) {
+        emit succeeded();
+    } else {
+        emit failed();
+    }
+}
+
+void ConnectivityProbe::abortReplies()
+{
+    const QList<QNetworkReply *> replies = m_replies;
+    m_replies.clear();
+    for (QNetworkReply *reply : replies) {
+        forgetAttempt(reply);
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+}
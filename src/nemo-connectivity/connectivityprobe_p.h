@@ -0,0 +1,156 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_CONNECTIVITYPROBE_P_H
+#define NEMO_CONNECTIVITYPROBE_P_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+
+#include "connectivitypolicy.h"
+#include "linkquality.h"
+
+QT_BEGIN_NAMESPACE
+class QHostInfo;
+class QNetworkAccessManager;
+class QNetworkReply;
+QT_END_NAMESPACE
+
+namespace Nemo {
+
+/*
+    What a canary check asks for and accepts. Helpers asking for the same
+    parameters can share a probe.
+*/
+struct ProbeParameters
+{
+    ProbeParameters();
+    bool operator==(const ProbeParameters &other) const;
+
+    QStringList fallbackUrls;
+    ConnectivityPolicy::ProbeMethod method;
+    QList<int> expectedStatusCodes;
+    QByteArray expectedBody;
+};
+
+/*
+    Races canary requests against a list of status check urls, Happy Eyeballs
+    style. The first url is requested immediately and each following one
+    after a short attempt delay, or as soon as an earlier attempt fails.
+
+    Each reply is judged from its status code and headers, and optionally
+    the first bytes of its body, and aborted as soon as that is known.
+    The probe resolves on the first conclusive answer, online or captive
+    portal, and fails once every attempt has failed. The timing of the
+    deciding reply is reported just before that. A reply deciding online is
+    left to complete rather than aborted, so that its connection stays in
+    the network access manager's pool for the next request to that host.
+*/
+class ConnectivityProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConnectivityProbe(QNetworkAccessManager *manager, const ProbeParameters &parameters,
+                      QObject *parent = nullptr);
+    ~ConnectivityProbe();
+
+    ProbeParameters parameters() const;
+
+    // Replies from connmanUrls are also checked for connman's status header.
+    void start(const QList<QUrl> &urls, const QList<QUrl> &connmanUrls);
+    void abort();
+    bool isRunning() const;
+
+Q_SIGNALS:
+    // rttSample is -1 if the reply tells nothing about the round-trip time.
+    void measured(const Nemo::ProbeTiming &timing, int rttSample, bool newTlsConnection);
+    void succeeded();
+    void failed();
+
+private Q_SLOTS:
+    void hostLookedUp(const QHostInfo &info);
+
+private:
+    enum Verdict {
+        Undecided,
+        Online,
+        CaptivePortal,
+        Inconclusive
+    };
+
+    // Milliseconds since the request was issued at which each phase ended,
+    // or -1 if not (yet) seen.
+    struct Attempt
+    {
+        Attempt();
+
+        QElapsedTimer timer;
+        int lookupId;
+        qint64 dnsLookup;
+        qint64 connectStarted;
+        qint64 encrypted;
+        qint64 requestSent;
+        qint64 firstByte;
+        QByteArray body;
+    };
+
+    void startNextAttempt();
+    void attemptFinished(QNetworkReply *reply);
+    Verdict headerVerdict(QNetworkReply *reply) const;
+    Verdict bodyVerdict(QNetworkReply *reply);
+    bool isExpectedStatusCode(int statusCode) const;
+    bool expectsBody() const;
+    void conclude(QNetworkReply *reply, Verdict verdict);
+    void reportTiming(QNetworkReply *reply);
+    void forgetAttempt(QNetworkReply *reply);
+    void keepAlive(QNetworkReply *reply);
+    void finish(bool online);
+    void abortReplies();
+
+    QNetworkAccessManager *m_manager;
+    ProbeParameters m_parameters;
+    QList<QUrl> m_urls;
+    QList<QUrl> m_connmanUrls;
+    QList<QNetworkReply *> m_replies;
+    QHash<QNetworkReply *, Attempt> m_attempts;
+    QHash<int, QNetworkReply *> m_lookups;
+    QTimer m_attemptDelayTimer;
+    int m_nextAttempt;
+    bool m_running;
+};
+
+}
+
+#endif
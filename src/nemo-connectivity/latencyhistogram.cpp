@@ -0,0 +1,162 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "latencyhistogram.h"
+
+#include <QStringList>
+#include <QVariantList>
+
+namespace {
+
+// Buckets up to 2^19 ms, the last one catches the rest.
+const int BoundedBucketCount = 20;
+
+}
+
+namespace Nemo {
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(BoundedBucketCount + 1, 0)
+    , m_count(0)
+    , m_minimum(0)
+    , m_maximum(0)
+    , m_sum(0)
+{
+}
+
+void LatencyHistogram::add(qint64 milliseconds)
+{
+    milliseconds = qMax<qint64>(milliseconds, 0);
+
+    int bucket = 0;
+    while (bucket < BoundedBucketCount && milliseconds > bucketUpperBound(bucket)) {
+        ++bucket;
+    }
+    ++m_buckets[bucket];
+
+    m_minimum = m_count == 0 ? milliseconds : qMin(m_minimum, milliseconds);
+    m_maximum = qMax(m_maximum, milliseconds);
+    m_sum += milliseconds;
+    ++m_count;
+}
+
+int LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 LatencyHistogram::minimum() const
+{
+    return m_count > 0 ? m_minimum : -1;
+}
+
+qint64 LatencyHistogram::maximum() const
+{
+    return m_count > 0 ? m_maximum : -1;
+}
+
+qint64 LatencyHistogram::mean() const
+{
+    return m_count > 0 ? m_sum / m_count : -1;
+}
+
+qint64 LatencyHistogram::percentile(qreal fraction) const
+{
+    if (m_count == 0) {
+        return -1;
+    }
+
+    const qreal wanted = qBound<qreal>(0, fraction, 1) * m_count;
+    int seen = 0;
+    for (int bucket = 0; bucket < m_buckets.count(); ++bucket) {
+        seen += m_buckets.at(bucket);
+        if (seen > 0 && seen >= wanted) {
+            const qint64 bound = bucketUpperBound(bucket);
+            return bound < 0 ? m_maximum : qMin(bound, m_maximum);
+        }
+    }
+    return m_maximum;
+}
+
+QVector<int> LatencyHistogram::buckets() const
+{
+    return m_buckets;
+}
+
+int LatencyHistogram::bucketCount()
+{
+    return BoundedBucketCount + 1;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+    return bucket < BoundedBucketCount ? Q_INT64_C(1) << bucket : -1;
+}
+
+QVariantMap LatencyHistogram::toVariantMap() const
+{
+    QVariantList buckets;
+    for (int value : m_buckets) {
+        buckets.append(value);
+    }
+
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), m_count);
+    map.insert(QStringLiteral("minimum"), minimum());
+    map.insert(QStringLiteral("maximum"), maximum());
+    map.insert(QStringLiteral("mean"), mean());
+    map.insert(QStringLiteral("median"), percentile(0.5));
+    map.insert(QStringLiteral("p90"), percentile(0.9));
+    map.insert(QStringLiteral("p99"), percentile(0.99));
+    map.insert(QStringLiteral("buckets"), buckets);
+    return map;
+}
+
+QString LatencyHistogram::toString() const
+{
+    QStringList buckets;
+    for (int bucket = 0; bucket < m_buckets.count(); ++bucket) {
+        if (m_buckets.at(bucket) > 0) {
+            const qint64 bound = bucketUpperBound(bucket);
+            buckets.append(QStringLiteral("%1:%2")
+                           .arg(bound < 0 ? QStringLiteral("inf") : QString::number(bound))
+                           .arg(m_buckets.at(bucket)));
+        }
+    }
+
+    return QStringLiteral("n=%1 min=%2 median=%3 p90=%4 p99=%5 max=%6 [%7]")
+            .arg(m_count)
+            .arg(minimum())
+            .arg(percentile(0.5))
+            .arg(percentile(0.9))
+            .arg(percentile(0.99))
+            .arg(maximum())
+            .arg(buckets.join(QLatin1Char(' ')));
+}
+
+}
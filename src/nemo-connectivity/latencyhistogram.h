@@ -0,0 +1,79 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_LATENCYHISTOGRAM_H
+#define NEMO_LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <nemo-connectivity/global.h>
+
+namespace Nemo {
+
+/*
+    Distribution of durations in milliseconds over power of two buckets,
+    from 1 ms up to about 9 min, plus one for anything longer.
+*/
+class NEMO_CONNECTIVITY_EXPORT LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void add(qint64 milliseconds);
+
+    int count() const;
+    qint64 minimum() const;
+    qint64 maximum() const;
+    qint64 mean() const;
+
+    // Upper bound of the bucket holding the given fraction of the samples,
+    // capped to the largest sample. -1 when empty.
+    qint64 percentile(qreal fraction) const;
+
+    QVector<int> buckets() const;
+
+    static int bucketCount();
+    // -1 for the last bucket, which has no upper bound.
+    static qint64 bucketUpperBound(int bucket);
+
+    QVariantMap toVariantMap() const;
+    QString toString() const;
+
+private:
+    QVector<int> m_buckets;
+    int m_count;
+    qint64 m_minimum;
+    qint64 m_maximum;
+    qint64 m_sum;
+};
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "linkquality.h"
+
+namespace Nemo {
+
+ProbeTiming::ProbeTiming()
+    : dnsLookup(-1)
+    , connect(-1)
+    , tlsHandshake(-1)
+    , firstByte(-1)
+    , total(-1)
+{
+}
+
+QVariantMap ProbeTiming::toVariantMap() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("dnsLookup"), dnsLookup);
+    map.insert(QStringLiteral("connect"), connect);
+    map.insert(QStringLiteral("tlsHandshake"), tlsHandshake);
+    map.insert(QStringLiteral("firstByte"), firstByte);
+    map.insert(QStringLiteral("total"), total);
+    return map;
+}
+
+LinkQuality::LinkQuality()
+    : rtt(-1)
+    , jitter(-1)
+    , samples(0)
+    , bandwidth(-1)
+{
+}
+
+bool LinkQuality::isValid() const
+{
+    return samples > 0;
+}
+
+}
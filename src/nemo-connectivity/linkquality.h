@@ -0,0 +1,84 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_LINKQUALITY_H
+#define NEMO_LINKQUALITY_H
+
+#include <QMetaType>
+#include <QVariantMap>
+
+#include <nemo-connectivity/global.h>
+
+namespace Nemo {
+
+/*
+    Where the time of a canary request went, in milliseconds. A phase that
+    could not be observed is -1. With Qt 6.3 and later connection setup is
+    timed from the socket starting to connect to the request being sent,
+    and firstByte from then on. Before that it is only visible when a new
+    TLS connection is made; for plain HTTP it is part of firstByte.
+*/
+struct NEMO_CONNECTIVITY_EXPORT ProbeTiming
+{
+    ProbeTiming();
+
+    QVariantMap toVariantMap() const;
+
+    int dnsLookup;      // resolving the status check host
+    int connect;        // from starting to connect, or the name being resolved, to the connection being ready
+    int tlsHandshake;   // the part of connect spent in TLS, estimated from rtt
+    int firstByte;      // from the connection being ready to the reply headers
+    int total;          // from issuing the request to the reply headers
+};
+
+/*
+    Smoothed round-trip time and its variation over the canary requests
+    made on the current default route, in milliseconds. Estimated the way
+    TCP does (RFC 6298) and reset whenever the default route changes.
+    The downstream bandwidth, in kbit/s, is estimated likewise from large
+    downloads through the shared network access manager.
+*/
+struct NEMO_CONNECTIVITY_EXPORT LinkQuality
+{
+    LinkQuality();
+
+    bool isValid() const;
+
+    int rtt;
+    int jitter;
+    int samples;
+    int bandwidth;
+    ProbeTiming lastProbe;
+};
+
+}
+
+Q_DECLARE_METATYPE(Nemo::ProbeTiming)
+Q_DECLARE_METATYPE(Nemo::LinkQuality)
+
+#endif
@@ -0,0 +1,169 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "linkwatcher_p.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <errno.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#ifndef IFF_LOWER_UP
+// only in <linux/if.h>, which clashes with <net/if.h>.
+#define IFF_LOWER_UP 0x10000
+#endif
+
+namespace {
+
+QString interfaceName(int index, struct ifinfomsg *info, int length)
+{
+    // the name is part of link messages, even for links already gone.
+    if (info) {
+        for (struct rtattr *attribute = IFLA_RTA(info); RTA_OK(attribute, length);
+             attribute = RTA_NEXT(attribute, length)) {
+            if (attribute->rta_type == IFLA_IFNAME) {
+                return QString::fromLocal8Bit(static_cast<const char *>(RTA_DATA(attribute)));
+            }
+        }
+    }
+
+    char name[IF_NAMESIZE];
+    if (if_indextoname(index, name)) {
+        return QString::fromLocal8Bit(name);
+    }
+    return QString();
+}
+
+}
+
+namespace Nemo {
+
+LinkWatcher::LinkWatcher(QObject *parent)
+    : QObject(parent)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+{
+    m_socket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (m_socket < 0) {
+        qWarning() << "Unable to open netlink socket:" << strerror(errno);
+        return;
+    }
+
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(m_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+        qWarning() << "Unable to bind netlink socket:" << strerror(errno);
+        ::close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &LinkWatcher::readMessages);
+}
+
+LinkWatcher::~LinkWatcher()
+{
+    delete m_notifier;
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+}
+
+bool LinkWatcher::isValid() const
+{
+    return m_socket >= 0;
+}
+
+void LinkWatcher::readMessages()
+{
+    char buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    for (;;) {
+        int length = ::recv(m_socket, buffer, sizeof(buffer), 0);
+        if (length < 0) {
+            if (errno == ENOBUFS) {
+                // the kernel dropped notifications, forget what we knew.
+                m_carrier.clear();
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                qWarning() << "Unable to read netlink socket:" << strerror(errno);
+            }
+            return;
+        }
+
+        for (struct nlmsghdr *header = reinterpret_cast<struct nlmsghdr *>(buffer);
+             NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            switch (header->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK: {
+                struct ifinfomsg *info = static_cast<struct ifinfomsg *>(NLMSG_DATA(header));
+                const bool carrier = header->nlmsg_type == RTM_NEWLINK
+                        && (info->ifi_flags & IFF_LOWER_UP);
+                const auto known = m_carrier.constFind(info->ifi_index);
+                if (known == m_carrier.constEnd() ? !carrier : *known != carrier) {
+                    const QString name = interfaceName(info->ifi_index, info, IFLA_PAYLOAD(header));
+                    if (!name.isEmpty()) {
+                        emit carrierChanged(name, carrier);
+                    }
+                }
+                if (header->nlmsg_type == RTM_DELLINK) {
+                    m_carrier.remove(info->ifi_index);
+                } else {
+                    m_carrier.insert(info->ifi_index, carrier);
+                }
+                break;
+            }
+            case RTM_NEWADDR:
+            case RTM_DELADDR: {
+                struct ifaddrmsg *info = static_cast<struct ifaddrmsg *>(NLMSG_DATA(header));
+                const QString name = interfaceName(info->ifa_index, nullptr, 0);
+                if (!name.isEmpty()) {
+                    emit addressesChanged(name);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_LINKWATCHER_P_H
+#define NEMO_LINKWATCHER_P_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+QT_END_NAMESPACE
+
+namespace Nemo {
+
+/*
+    Listens to rtnetlink link and address notifications, which the kernel
+    sends as soon as a carrier drops or an address goes away, well before
+    connman has processed the change and told us over D-Bus.
+
+    Depends on nothing but the kernel, so it can be exercised with dummy or
+    veth interfaces in a network namespace.
+*/
+class LinkWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LinkWatcher(QObject *parent = nullptr);
+    ~LinkWatcher();
+
+    bool isValid() const;
+
+Q_SIGNALS:
+    void carrierChanged(const QString &interface, bool carrier);
+    void addressesChanged(const QString &interface);
+
+private Q_SLOTS:
+    void readMessages();
+
+private:
+    int m_socket;
+    QSocketNotifier *m_notifier;
+    QHash<int, bool> m_carrier; // by interface index
+};
+
+}
+
+#endif
@@ -32,6 +32,16 @@
 #include "mobiledataconnection.h"
 #include "mobiledataconnection_p.h"
 
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMessageAuthenticationCode>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUuid>
+#include <QWeakPointer>
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <connman-qt6/networkservice.h>
 #else
@@ -40,8 +50,374 @@
 
 Q_LOGGING_CATEGORY(CONNECTIVITY, "qt.nemo.connectivity", QtWarningMsg)
 
+namespace {
+
+QHash<QString, QWeakPointer<Nemo::MobileDataModem> > sharedModems;
+QWeakPointer<Nemo::CellularServiceIndex> sharedServiceIndex;
+
+const QString CellularServicePrefix = QStringLiteral("/net/connman/service/cellular_");
+
+// Cellular service paths are made of the IMSI and the context name.
+bool parseCellularService(const QString &servicePath, QString *subscriberIdentity, QString *context)
+{
+    if (!servicePath.startsWith(CellularServicePrefix)) {
+        return false;
+    }
+
+    int separator = servicePath.indexOf(QLatin1Char('_'), CellularServicePrefix.length());
+    if (separator < 0) {
+        return false;
+    }
+
+    *subscriberIdentity = servicePath.mid(CellularServicePrefix.length(),
+                                          separator - CellularServicePrefix.length());
+    *context = servicePath.mid(separator + 1);
+    return !subscriberIdentity->isEmpty() && !context->isEmpty();
+}
+
+// Records value as the last one notified, returning whether it differs.
+template <typename T>
+bool notifiedChange(T *notified, const T &value)
+{
+    if (*notified == value) {
+        return false;
+    }
+    *notified = value;
+    return true;
+}
+
+// Cached state is only shown until live data arrives or this expires.
+const int StaleStateTimeout = 10000; // 10 sec
+
+// Changes to the cached state are written at most this often.
+const int SnapshotWriteDelay = 10000; // 10 sec
+
+const QString SnapshotSalt = QStringLiteral("salt");
+const QString SnapshotModems = QStringLiteral("Modems");
+const QString SnapshotConnectionName = QStringLiteral("connectionName");
+const QString SnapshotServiceProviderName = QStringLiteral("serviceProviderName");
+const QString SnapshotAutoConnect = QStringLiteral("autoConnect");
+const QString SnapshotStatus = QStringLiteral("status");
+
+// Kept in the application's own cache, not shared with other applications.
+QString snapshotFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QStringLiteral("/nemo-connectivity/mobiledata.conf");
+}
+
+// Random per installation, so that the stored digests can't be looked up
+// from IMSIs enumerated under a known MCC and MNC.
+QByteArray snapshotSalt()
+{
+    static QByteArray salt;
+    if (salt.isEmpty()) {
+        QSettings settings(snapshotFile(), QSettings::IniFormat);
+        salt = QByteArray::fromHex(settings.value(SnapshotSalt).toString().toLatin1());
+        if (salt.isEmpty()) {
+            salt = QUuid::createUuid().toRfc4122() + QUuid::createUuid().toRfc4122();
+            QDir().mkpath(QFileInfo(snapshotFile()).absolutePath());
+            settings.setValue(SnapshotSalt, QString::fromLatin1(salt.toHex()));
+        }
+    }
+    return salt;
+}
+
+// State is kept per SIM, under a keyed digest rather than the IMSI itself.
+QString subscriberKey(const QString &subscriberIdentity)
+{
+    return QString::fromLatin1(QMessageAuthenticationCode::hash(subscriberIdentity.toUtf8(), snapshotSalt(),
+                                                                QCryptographicHash::Sha256).toHex());
+}
+
+// The SIM last seen in a modem, so that its state can be found before
+// ofono has told the IMSI. QSettings would take the slashes of a modem
+// path as nested groups.
+QString modemKey(const QString &modemPath)
+{
+    QString key = modemPath;
+    return SnapshotModems + QLatin1Char('/') + key.replace(QLatin1Char('/'), QLatin1Char('_'));
+}
+
+QVariantMap readSnapshot(const QString &modemPath, QString *key)
+{
+    QSettings settings(snapshotFile(), QSettings::IniFormat);
+
+    QVariantMap snapshot;
+    *key = settings.value(modemKey(modemPath)).toString();
+    if (key->isEmpty()) {
+        return snapshot;
+    }
+
+    settings.beginGroup(*key);
+    if (!settings.contains(SnapshotStatus)) {
+        return snapshot;
+    }
+
+    snapshot.insert(SnapshotConnectionName, settings.value(SnapshotConnectionName).toString());
+    snapshot.insert(SnapshotServiceProviderName, settings.value(SnapshotServiceProviderName).toString());
+    snapshot.insert(SnapshotAutoConnect, settings.value(SnapshotAutoConnect).toBool());
+    snapshot.insert(SnapshotStatus, settings.value(SnapshotStatus, Nemo::MobileDataConnection::Unknown).toInt());
+    return snapshot;
+}
+
+void writeSnapshot(const QString &modemPath, const QString &key, const QVariantMap &snapshot)
+{
+    QDir().mkpath(QFileInfo(snapshotFile()).absolutePath());
+
+    QSettings settings(snapshotFile(), QSettings::IniFormat);
+    settings.setValue(modemKey(modemPath), key);
+
+    settings.beginGroup(key);
+    for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it) {
+        settings.setValue(it.key(), it.value());
+    }
+}
+
+}
+
 namespace Nemo {
 
+CellularServiceIndex::CellularServiceIndex()
+    : m_networkManager(NetworkManager::sharedInstance())
+{
+    connect(m_networkManager.data(), &NetworkManager::serviceAdded, this, [=](const QString &servicePath) {
+        QString subscriberIdentity;
+        if (addService(servicePath, &subscriberIdentity)) {
+            emit servicesChanged(subscriberIdentity);
+        }
+    });
+    connect(m_networkManager.data(), &NetworkManager::serviceRemoved, this, [=](const QString &servicePath) {
+        QString subscriberIdentity;
+        if (removeService(servicePath, &subscriberIdentity)) {
+            emit servicesChanged(subscriberIdentity);
+        }
+    });
+    connect(m_networkManager.data(), &NetworkManager::availabilityChanged, this, [=]() {
+        rebuild();
+        emit servicesChanged(QString());
+    });
+
+    rebuild();
+}
+
+QSharedPointer<CellularServiceIndex> CellularServiceIndex::sharedInstance()
+{
+    QSharedPointer<CellularServiceIndex> index = sharedServiceIndex.toStrongRef();
+    if (!index) {
+        index = QSharedPointer<CellularServiceIndex>(new CellularServiceIndex, &QObject::deleteLater);
+        sharedServiceIndex = index;
+    }
+    return index;
+}
+
+/*
+    Returns the connman service of \a context on the SIM \a subscriberIdentity,
+    or an empty string when connman has none.
+*/
+QString CellularServiceIndex::servicePath(const QString &subscriberIdentity, const QString &context) const
+{
+    auto contexts = m_services.constFind(subscriberIdentity);
+    if (contexts == m_services.constEnd()) {
+        return QString();
+    }
+    return contexts->value(context);
+}
+
+/*
+    Reads the full list of cellular services. This is only needed when
+    connman (re)appears, after that services are tracked one by one.
+*/
+void CellularServiceIndex::rebuild()
+{
+    m_services.clear();
+
+    QString subscriberIdentity;
+    const QStringList services = m_networkManager->servicesList(QLatin1String("cellular"));
+    for (const QString &servicePath : services) {
+        addService(servicePath, &subscriberIdentity);
+    }
+}
+
+bool CellularServiceIndex::addService(const QString &servicePath, QString *subscriberIdentity)
+{
+    QString context;
+    if (!parseCellularService(servicePath, subscriberIdentity, &context)) {
+        return false;
+    }
+
+    m_services[*subscriberIdentity].insert(context, servicePath);
+    return true;
+}
+
+bool CellularServiceIndex::removeService(const QString &servicePath, QString *subscriberIdentity)
+{
+    QString context;
+    if (!parseCellularService(servicePath, subscriberIdentity, &context)) {
+        return false;
+    }
+
+    auto contexts = m_services.find(*subscriberIdentity);
+    if (contexts == m_services.end() || contexts->remove(context) == 0) {
+        return false;
+    }
+
+    if (contexts->isEmpty()) {
+        m_services.erase(contexts);
+    }
+    return true;
+}
+
+MobileDataModem::MobileDataModem(const QString &modemPath)
+    : modemManager(QOfonoExtModemManager::instance())
+    , networkManager(NetworkManager::sharedInstance())
+    , serviceIndex(CellularServiceIndex::sharedInstance())
+    , networkService(new NetworkService(this))
+    , connectionContext(nullptr)
+{
+    simManager.setModemPath(modemPath);
+    networkRegistration.setModemPath(modemPath);
+
+    connect(&simManager, &QOfonoSimManager::validChanged, this, [=]() {
+        updateServicePath();
+    });
+    connect(&simManager, &QOfonoSimManager::presenceChanged, this, [=]() {
+        updateServicePath();
+    });
+    connect(&simManager, &QOfonoSimManager::subscriberIdentityChanged, this, [=]() {
+        updateServicePath();
+    });
+
+    connect(serviceIndex.data(), &CellularServiceIndex::servicesChanged,
+            this, [=](const QString &subscriberIdentity) {
+        if (subscriberIdentity.isEmpty() || subscriberIdentity == simManager.subscriberIdentity()) {
+            updateServicePath();
+        }
+    });
+    connect(modemManager.data(), &QOfonoExtModemManager::defaultDataSimChanged, this, [=]() {
+        updateServicePath();
+    });
+
+    if (modemPath.isEmpty()) {
+        return;
+    }
+
+    connectionManager = QOfonoConnectionManager::instance(modemPath);
+    connectionManager->setFilter(QLatin1String("internet"));
+
+    connect(connectionManager.data(), &QOfonoConnectionManager::contextsChanged, this, [=]() {
+        qCDebug(CONNECTIVITY, "QOfonoConnectionManager::contextsChanged context path: %s %s",
+                qPrintable(connectionManager->contexts().join(",")), qPrintable(modemPath));
+        updateDataContext();
+    });
+    connect(connectionManager.data(), &QOfonoConnectionManager::poweredChanged, this, [=]() {
+        updateDataContext();
+    });
+
+    connectionContext = new QOfonoConnectionContext(this);
+    connect(connectionContext, &QOfonoConnectionContext::contextPathChanged, this, [=](const QString &contextPath) {
+        qCDebug(CONNECTIVITY) << "QOfonoConnectionContext contextPathChanged" << contextPath << modemPath;
+        if (contextPath.isEmpty()) {
+            networkService->setPath(QString());
+        } else {
+            updateServicePath();
+        }
+    });
+
+    updateDataContext();
+}
+
+MobileDataModem::~MobileDataModem()
+{
+    const QString path = modemPath();
+    if (sharedModems.value(path).isNull()) {
+        sharedModems.remove(path);
+    }
+
+    connectionManager.reset();
+}
+
+/*
+    Returns the proxies for \a modemPath, creating them when no connection
+    follows that modem yet. They are released with the last connection.
+*/
+QSharedPointer<MobileDataModem> MobileDataModem::instance(const QString &modemPath)
+{
+    QSharedPointer<MobileDataModem> modem = sharedModems.value(modemPath).toStrongRef();
+    if (!modem) {
+        // the last connection may go away while handling one of our signals.
+        modem = QSharedPointer<MobileDataModem>(new MobileDataModem(modemPath), &QObject::deleteLater);
+        sharedModems.insert(modemPath, modem);
+    }
+    return modem;
+}
+
+QString MobileDataModem::modemPath() const
+{
+    return simManager.modemPath();
+}
+
+bool MobileDataModem::isSimManagerValid() const
+{
+    return simManager.isValid() && simManager.present();
+}
+
+bool MobileDataModem::isDataContextReady() const
+{
+    return connectionManager && connectionManager->powered() && !connectionManager->contexts().isEmpty();
+}
+
+bool MobileDataModem::hasDataContext() const
+{
+    return connectionManager && connectionContext;
+}
+
+QString MobileDataModem::servicePathForContext() const
+{
+    if (contextName.isEmpty() || !isSimManagerValid()) {
+        return QString();
+    }
+
+    QString servicePath = serviceIndex->servicePath(simManager.subscriberIdentity(), contextName);
+    if (!servicePath.isEmpty()) {
+        qCDebug(CONNECTIVITY, "Service path for context: %s %s",
+                qPrintable(servicePath), qPrintable(modemPath()));
+    }
+    return servicePath;
+}
+
+void MobileDataModem::updateDataContext()
+{
+    if (!hasDataContext()) {
+        return;
+    }
+
+    if (isDataContextReady()) {
+        QStringList contexts = connectionManager->contexts();
+        qCDebug(CONNECTIVITY, "####### Set data context: %s m: %s", qPrintable(contexts.join(",")),
+                qPrintable(modemPath()));
+        inetContextPath = contexts.at(0);
+        contextName = inetContextPath.section('/', -1);
+        connectionContext->setContextPath(inetContextPath);
+    } else if (!connectionManager->powered()) {
+        qCDebug(CONNECTIVITY, "######## Set powered ON");
+        connectionManager->setPowered(true);
+
+        NetworkTechnology *technology = networkManager->getTechnology(QStringLiteral("cellular"));
+        if (technology) {
+            technology->setPowered(true);
+        }
+    }
+}
+
+void MobileDataModem::updateServicePath()
+{
+    QString servicePath = servicePathForContext();
+    if (networkService->path() != servicePath) {
+        networkService->setPath(servicePath);
+    }
+}
+
 MobileDataConnectionPrivate::MobileDataConnectionPrivate(MobileDataConnection *q)
     : valid(false)
     , simManagerValid(false)
@@ -50,39 +426,51 @@ MobileDataConnectionPrivate::MobileDataConnectionPrivate(MobileDataConnection *q
     , status(MobileDataConnection::Unknown)
     , connectingService(false)
     , useDefaultModem(false)
+    , pendingChanges(0)
+    , updateScheduled(false)
+    , useCachedState(false)
+    , stale(false)
+    , heldChanges(0)
+    , snapshotPending(false)
+    , notifiedSlotIndex(-1)
+    , notifiedSlotCount(0)
+    , notifiedConnected(false)
+    , notifiedAutoConnect(false)
+    , notifiedSaved(false)
+    , notifiedRoaming(false)
+    , notifiedRoamingAllowed(false)
+    , notifiedPresentSimCount(0)
+    , notifiedOfflineMode(false)
+    , notifiedStale(false)
     , q(q)
     , modemManager(QOfonoExtModemManager::instance())
-    , simManager(q)
     , networkManager(NetworkManager::sharedInstance())
-    , networkService(new NetworkService(q))
     , networkTechnology(nullptr)
-    , networkRegistration(q)
-    , connectionManager(nullptr)
-    , connectionContext(nullptr)
 {
+    staleTimer.setSingleShot(true);
+    staleTimer.setInterval(StaleStateTimeout);
+    snapshotTimer.setSingleShot(true);
+    snapshotTimer.setInterval(SnapshotWriteDelay);
+    snapshotTimer.setTimerType(Qt::CoarseTimer);
 }
 
 MobileDataConnectionPrivate::~MobileDataConnectionPrivate()
 {
+    writePendingSnapshot();
     modemManager.reset();
-
-    delete networkService;
-    networkService = nullptr;
-
-    connectionManager.reset();
-    delete connectionContext;
-    connectionContext = nullptr;
+    modem.reset();
 }
 
 bool MobileDataConnectionPrivate::isValid() const
 {
-    qCDebug(CONNECTIVITY) << "isValid:" << (networkService && networkService->isValid() && !networkService->path().isEmpty())
-                          << (connectionManager && connectionManager->isValid())
-                          << (connectionContext && connectionContext->isValid())
-                          << (networkService && networkService->available());
-    return networkService && networkService->isValid() && !networkService->path().isEmpty()
-            && connectionManager && connectionManager->isValid()
-            && connectionContext && connectionContext->isValid()
+    NetworkService *networkService = modem->networkService;
+    qCDebug(CONNECTIVITY) << "isValid:" << (networkService->isValid() && !networkService->path().isEmpty())
+                          << (modem->connectionManager && modem->connectionManager->isValid())
+                          << (modem->connectionContext && modem->connectionContext->isValid())
+                          << networkService->available();
+    return networkService->isValid() && !networkService->path().isEmpty()
+            && modem->connectionManager && modem->connectionManager->isValid()
+            && modem->connectionContext && modem->connectionContext->isValid()
             && networkService->available();
 }
 
@@ -90,8 +478,8 @@ void MobileDataConnectionPrivate::updateValid()
 {
     bool v = isValid();
     qCDebug(CONNECTIVITY, "Update valid old: %d new: %d modem: %s connecting: %d %s available: %d %s",
-            valid, v, qPrintable(q->modemPath()), connectingService, qPrintable(networkService->path()),
-            networkService->available(), qPrintable(q->objectName()));
+            valid, v, qPrintable(q->modemPath()), connectingService, qPrintable(modem->networkService->path()),
+            modem->networkService->available(), qPrintable(q->objectName()));
     if (valid != v) {
         valid = v;
         emit q->validChanged();
@@ -100,13 +488,13 @@ void MobileDataConnectionPrivate::updateValid()
 
 bool MobileDataConnectionPrivate::isSimManagerValid() const
 {
-    return simManager.isValid() && simManager.present();
+    return modem->isSimManagerValid();
 }
 
 void MobileDataConnectionPrivate::updateStatus()
 {
     MobileDataConnection::Status oldStatus = status;
-    NetworkService::ServiceState state = networkService->serviceState();
+    NetworkService::ServiceState state = modem->networkService->serviceState();
 
     bool connecting = state == NetworkService::AssociationState || state == NetworkService::ConfigurationState;
     if (q->connected()) {
@@ -131,25 +519,264 @@ void MobileDataConnectionPrivate::updateStatus()
             qPrintable(state), connectingService, qPrintable(q->objectName()));
 }
 
-void MobileDataConnectionPrivate::updateNetworkServicePath()
+void MobileDataConnectionPrivate::scheduleUpdate(int changes)
+{
+    pendingChanges |= changes;
+    if (!updateScheduled) {
+        updateScheduled = true;
+        QTimer::singleShot(0, q, [=]() {
+            runUpdate();
+        });
+    }
+}
+
+/*
+    Applies everything that changed since the last pass in dependency
+    order, so that a burst of ofono and connman signals recomputes the
+    state once and notifies each property at most once, and only when
+    its value differs from the one last notified.
+*/
+void MobileDataConnectionPrivate::runUpdate()
 {
-    bool simMgrValid = isSimManagerValid();
-    qCDebug(CONNECTIVITY()) << "MobileDataConnection update network service path:" << simManager.isValid()
-                            << simManager.present() << simManagerValid
-                            << "auto connect service:" << networkService->autoConnect()
-                            << "pending auto connect:" << autoConnectPending
-                            << "d_ptr->autoConnect: " << autoConnect;
-    if (simMgrValid != simManagerValid) {
-        simManagerValid = simMgrValid;
+    updateScheduled = false;
+    int changes = pendingChanges;
+    pendingChanges = 0;
+
+    if (changes & SimChange) {
+        bool simMgrValid = isSimManagerValid();
+        qCDebug(CONNECTIVITY()) << "MobileDataConnection update network service path:" << modem->simManager.isValid()
+                                << modem->simManager.present() << simManagerValid
+                                << "auto connect service:" << modem->networkService->autoConnect()
+                                << "pending auto connect:" << autoConnectPending
+                                << "d_ptr->autoConnect: " << autoConnect;
+        if (simMgrValid != simManagerValid) {
+            simManagerValid = simMgrValid;
+            changes |= SubscriberIdentityChange | ServiceProviderNameChange | TechnologyChange;
+        }
+    }
+
+    if (stale) {
+        heldChanges |= changes & SnapshotChanges;
+        changes &= ~SnapshotChanges;
+    }
+
+    if (changes & SubscriberIdentityChange) {
         updateSubscriberIdentity();
+    }
+    if (changes & ServiceProviderNameChange) {
         updateServiceProviderName();
-        updateServiceAndTechnology();
     }
+    if (changes & TechnologyChange) {
+        updateTechnology();
+    }
+    if (changes & ConnectionNameChange) {
+        updateConnectionName();
+    }
+    if (changes & ValidChange) {
+        updateValid();
+    }
+    if (changes & StatusChange) {
+        updateStatus();
+    }
+
+    if (stale && (valid || snapshotMismatch())) {
+        endStale();
+    }
+    saveSnapshot();
+
+    if ((changes & ModemPathChange) && notifiedChange(&notifiedModemPath, q->modemPath())) {
+        emit q->modemPathChanged();
+    }
+    if ((changes & SlotIndexChange) && notifiedChange(&notifiedSlotIndex, q->slotIndex())) {
+        emit q->slotIndexChanged();
+    }
+    if ((changes & SlotCountChange) && notifiedChange(&notifiedSlotCount, q->slotCount())) {
+        emit q->slotCountChanged();
+    }
+    if ((changes & IdentifierChange) && notifiedChange(&notifiedIdentifier, q->identifier())) {
+        emit q->identifierChanged();
+    }
+    if ((changes & ConnectedChange) && notifiedChange(&notifiedConnected, q->connected())) {
+        emit q->connectedChanged();
+    }
+    if ((changes & AutoConnectChange) && notifiedChange(&notifiedAutoConnect, q->autoConnect())) {
+        emit q->autoConnectChanged();
+    }
+    if ((changes & ErrorChange) && notifiedChange(&notifiedError, q->error())) {
+        emit q->errorChanged();
+    }
+    if ((changes & SavedChange) && notifiedChange(&notifiedSaved, q->saved())) {
+        emit q->savedChanged();
+    }
+    if ((changes & RoamingChange) && notifiedChange(&notifiedRoaming, q->roaming())) {
+        emit q->roamingChanged();
+    }
+    if ((changes & RoamingAllowedChange) && notifiedChange(&notifiedRoamingAllowed, q->roamingAllowed())) {
+        emit q->roamingAllowedChanged();
+    }
+    if ((changes & DefaultDataSimChange) && notifiedChange(&notifiedDefaultDataSim, q->defaultDataSim())) {
+        emit q->defaultDataSimChanged();
+    }
+    if ((changes & PresentSimCountChange) && notifiedChange(&notifiedPresentSimCount, q->presentSimCount())) {
+        emit q->presentSimCountChanged();
+    }
+    if ((changes & OfflineModeChange) && notifiedChange(&notifiedOfflineMode, q->offlineMode())) {
+        emit q->offlineModeChanged();
+    }
+    if ((changes & StaleChange) && notifiedChange(&notifiedStale, q->isStale())) {
+        emit q->staleChanged();
+    }
+}
+
+/*
+    Takes the current values as already notified, e.g. once constructed,
+    when they are what a reader sees first.
+*/
+void MobileDataConnectionPrivate::rememberNotifiedValues()
+{
+    notifiedModemPath = q->modemPath();
+    notifiedSlotIndex = q->slotIndex();
+    notifiedSlotCount = q->slotCount();
+    notifiedIdentifier = q->identifier();
+    notifiedConnected = q->connected();
+    notifiedAutoConnect = q->autoConnect();
+    notifiedError = q->error();
+    notifiedSaved = q->saved();
+    notifiedRoaming = q->roaming();
+    notifiedRoamingAllowed = q->roamingAllowed();
+    notifiedDefaultDataSim = q->defaultDataSim();
+    notifiedPresentSimCount = q->presentSimCount();
+    notifiedOfflineMode = q->offlineMode();
+    notifiedStale = q->isStale();
+}
+
+QVariantMap MobileDataConnectionPrivate::currentSnapshot() const
+{
+    QVariantMap current;
+    current.insert(SnapshotConnectionName, connectionName);
+    current.insert(SnapshotServiceProviderName, serviceProviderName);
+    current.insert(SnapshotAutoConnect, q->autoConnect());
+    current.insert(SnapshotStatus, static_cast<int>(status));
+    return current;
+}
+
+/*
+    True once ofono tells the cached state belongs to another SIM, or that
+    there is no SIM at all.
+*/
+bool MobileDataConnectionPrivate::snapshotMismatch() const
+{
+    if (!modem->simManager.isValid()) {
+        return false;
+    }
+    if (!modem->simManager.present()) {
+        return true;
+    }
+
+    QString imsi = modem->simManager.subscriberIdentity();
+    return !imsi.isEmpty() && subscriberKey(imsi) != snapshotKey;
+}
+
+/*
+    Shows the state last saved for this modem until the live state is
+    known. Nothing is loaded when another connection already resolved the
+    modem's service.
+*/
+void MobileDataConnectionPrivate::loadSnapshot()
+{
+    const QString path = modem->modemPath();
+    if (!useCachedState || stale || path.isEmpty() || !modem->networkService->path().isEmpty()) {
+        return;
+    }
+
+    QString key;
+    QVariantMap cached = readSnapshot(path, &key);
+    if (cached.isEmpty()) {
+        return;
+    }
+
+    snapshot = cached;
+    snapshotKey = key;
+    stale = true;
+    connectionName = snapshot.value(SnapshotConnectionName).toString();
+    serviceProviderName = snapshot.value(SnapshotServiceProviderName).toString();
+    status = static_cast<MobileDataConnection::Status>(snapshot.value(SnapshotStatus).toInt());
+    staleTimer.start();
+
+    qCDebug(CONNECTIVITY, "Loaded cached state: %s status: %d %s",
+            qPrintable(path), status, qPrintable(q->objectName()));
+
+    notifiedAutoConnect = q->autoConnect();
+    notifiedStale = true;
+
+    emit q->connectionNameChanged();
+    emit q->serviceProviderNameChanged();
+    emit q->statusChanged();
+    emit q->autoConnectChanged();
+    emit q->staleChanged();
+}
+
+/*
+    Remembers the live state once it differs from what was last saved.
+    Writing is deferred, so that a burst of status changes ends up as a
+    single write of the final state.
+*/
+void MobileDataConnectionPrivate::saveSnapshot()
+{
+    if (!useCachedState || stale || !valid || subscriberIdentity.isEmpty()) {
+        return;
+    }
+
+    const QString key = subscriberKey(subscriberIdentity);
+    QVariantMap current = currentSnapshot();
+    if (key == snapshotKey && current == snapshot) {
+        return;
+    }
+
+    if (key != snapshotKey) {
+        // Still owed for the previous SIM.
+        writePendingSnapshot();
+    }
+
+    snapshot = current;
+    snapshotKey = key;
+    snapshotModemPath = modem->modemPath();
+    snapshotPending = true;
+    if (!snapshotTimer.isActive()) {
+        snapshotTimer.start();
+    }
+}
+
+void MobileDataConnectionPrivate::writePendingSnapshot()
+{
+    if (!snapshotPending) {
+        return;
+    }
+
+    snapshotPending = false;
+    snapshotTimer.stop();
+    writeSnapshot(snapshotModemPath, snapshotKey, snapshot);
+}
+
+/*
+    Lets the live state replace the cached one. Updates held back meanwhile
+    run in the next pass, which notifies only the values that differ.
+*/
+void MobileDataConnectionPrivate::endStale()
+{
+    if (!stale) {
+        return;
+    }
+
+    stale = false;
+    staleTimer.stop();
+    scheduleUpdate(heldChanges | SnapshotChanges | AutoConnectChange | StaleChange);
+    heldChanges = 0;
 }
 
 void MobileDataConnectionPrivate::updateSubscriberIdentity()
 {
-    QString newSubscriberIdentity = isSimManagerValid() ? simManager.subscriberIdentity() : QString();
+    QString newSubscriberIdentity = isSimManagerValid() ? modem->simManager.subscriberIdentity() : QString();
     if (subscriberIdentity != newSubscriberIdentity) {
         subscriberIdentity = newSubscriberIdentity;
         qCInfo(CONNECTIVITY) << "imsi:" << subscriberIdentity;
@@ -160,13 +787,22 @@ void MobileDataConnectionPrivate::updateSubscriberIdentity()
 
 void MobileDataConnectionPrivate::updateServiceProviderName()
 {
-    QString newName = isSimManagerValid() ? simManager.serviceProviderName() : QString();
+    QString newName = isSimManagerValid() ? modem->simManager.serviceProviderName() : QString();
     if (serviceProviderName != newName) {
         serviceProviderName = newName;
         emit q->serviceProviderNameChanged();
     }
 }
 
+void MobileDataConnectionPrivate::updateConnectionName()
+{
+    QString name = modem->connectionContext ? modem->connectionContext->name() : QString();
+    if (connectionName != name) {
+        connectionName = name;
+        emit q->connectionNameChanged();
+    }
+}
+
 void MobileDataConnectionPrivate::updateTechnology()
 {
     NetworkTechnology *newTech;
@@ -224,149 +860,183 @@ void MobileDataConnectionPrivate::updateTechnology()
     }
 }
 
-void MobileDataConnectionPrivate::updateServiceAndTechnology()
-{
-    networkService->setPath(servicePathForContext());
-    updateTechnology();
-}
-
-QString MobileDataConnectionPrivate::servicePathForContext()
+/*
+    Makes this connection follow \a modemPath, switching over to the shared
+    proxies of that modem and refreshing everything read from them.
+*/
+void MobileDataConnectionPrivate::bindModem(const QString &modemPath)
 {
-    if (inetContextPath.isEmpty()) {
-        return QString();
+    if (modem && modem->modemPath() == modemPath) {
+        return;
     }
 
-    QString imsi = subscriberIdentity;
-    if (imsi.isEmpty()) {
-        return QString();
-    }
+    qCDebug(CONNECTIVITY, "Bind modem: %s %s", qPrintable(modemPath), qPrintable(q->objectName()));
 
-    QStringList cellularServices = networkManager->servicesList(QLatin1String("cellular"));
-    if (cellularServices.isEmpty()) {
-        return QString();
-    }
+    bool wasStale = stale;
+    stale = false;
+    heldChanges = 0;
+    staleTimer.stop();
+    writePendingSnapshot();
+    snapshot.clear();
+    snapshotKey.clear();
 
-    QString context = inetContextPath.section('/', -1);
-    QString servicePath = "/net/connman/service/cellular_" + imsi + "_" + context;
+    disconnectModem();
+    modem = MobileDataModem::instance(modemPath);
+    connectModem();
 
-    if (cellularServices.contains(servicePath)) {
-        qCDebug(CONNECTIVITY, "Service path for context: %s %s",
-                qPrintable(servicePath), qPrintable(q->objectName()));
-        return servicePath;
+    if (modemPath.isEmpty()) {
+        connectingService = false;
     }
 
-    return QString();
-}
+    if (autoConnectPending && modem->networkService->isValid()) {
+        modem->networkService->setAutoConnect(autoConnect);
+        autoConnectPending = false;
+    }
 
-bool MobileDataConnectionPrivate::isDataContextReady(const QString &modemPath) const
-{
-    return connectionManager && connectionManager->powered() &&
-            !connectionManager->contexts().isEmpty() && !modemPath.isEmpty();
+    loadSnapshot();
+    if (wasStale && !stale) {
+        scheduleUpdate(StaleChange);
+    }
+
+    scheduleUpdate(SimChange | SubscriberIdentityChange | ServiceProviderNameChange | ConnectionNameChange
+                   | ValidChange | StatusChange | ModemPathChange | SlotIndexChange | IdentifierChange
+                   | ConnectedChange | AutoConnectChange | ErrorChange | SavedChange | RoamingChange
+                   | RoamingAllowedChange);
 }
 
-void MobileDataConnectionPrivate::createDataContext(const QString &modemPath)
+void MobileDataConnectionPrivate::connectModem()
 {
-    if (hasDataContext() || modemPath.isEmpty()) {
-        return;
-    }
+    NetworkService *networkService = modem->networkService;
 
-    connectionManager = QOfonoConnectionManager::instance(modemPath);
-    connectionManager->setFilter(QLatin1String("internet"));
+    QObject::connect(&modem->simManager, &QOfonoSimManager::validChanged, q, [=]() {
+        scheduleUpdate(SimChange);
+    });
+    QObject::connect(&modem->simManager, &QOfonoSimManager::presenceChanged, q, [=]() {
+        scheduleUpdate(SimChange);
+    });
+    QObject::connect(&modem->simManager, &QOfonoSimManager::subscriberIdentityChanged, q, [=]() {
+        scheduleUpdate(SubscriberIdentityChange);
+    });
+    QObject::connect(&modem->simManager, &QOfonoSimManager::serviceProviderNameChanged, q, [=]() {
+        scheduleUpdate(ServiceProviderNameChange);
+    });
 
-    QObject::connect(connectionManager.data(), &QOfonoConnectionManager::roamingAllowedChanged,
-                     q, &MobileDataConnection::roamingAllowedChanged);
-    QObject::connect(connectionManager.data(), &QOfonoConnectionManager::validChanged, q, [=]() {
-        qCDebug(CONNECTIVITY, "QOfonoConnectionManager::validChanged");
-        updateValid();
+    QObject::connect(networkService, &NetworkService::errorChanged, q, [=](const QString &error) {
+        if (!error.isEmpty()) {
+            connectingService = false;
+        }
+        scheduleUpdate(ErrorChange | StatusChange);
+    });
+    QObject::connect(networkService, &NetworkService::serviceStateChanged, q, [=]() {
+        // This and available should be clearly visible in the logs.
+        qCDebug(CONNECTIVITY) << "####################### MobileDataConnection::serviceStateChanged state:"
+                              << networkService->serviceState() << q->modemPath()
+                              << "available: " << networkService->available() << q->objectName();
+        scheduleUpdate(StatusChange);
     });
 
-    QObject::connect(connectionManager.data(), &QOfonoConnectionManager::contextsChanged, q, [=]() {
-        qCDebug(CONNECTIVITY, "QOfonoConnectionManager::contextsChanged context path: %s %s %s",
-                qPrintable(connectionManager->contexts().join(",")), qPrintable(q->modemPath()),
-                qPrintable(q->objectName()));
-        updateDataContext();
+    QObject::connect(networkService, &NetworkService::validChanged, q, [=]() {
+        qCDebug(CONNECTIVITY, "NetworkService::validChanged mobile data valid old: %d new %d auto connect %d pending auto %d, d_ptr->autoConnect: %d"
+                , valid , isValid()
+                , networkService->autoConnect(), autoConnectPending, autoConnect);
+        scheduleUpdate(ValidChange);
+        if (autoConnectPending) {
+            networkService->setAutoConnect(autoConnect);
+            autoConnectPending = false;
+        }
     });
 
-    QObject::connect(connectionManager.data(), &QOfonoConnectionManager::poweredChanged, q, [=]() {
-        updateDataContext();
+    QObject::connect(networkService, &NetworkService::availableChanged, q, [=]() {
+        qCDebug(CONNECTIVITY) << "####################### MobileDataConnection::availableChanged state: "
+                              << networkService->serviceState() << q->modemPath()
+                              << "available: " << networkService->available() << q->objectName();
+        scheduleUpdate(ValidChange | StatusChange);
     });
 
-    connectionContext = new QOfonoConnectionContext(q);
-    QObject::connect(connectionContext, &QOfonoConnectionContext::nameChanged, q, [=](const QString &name) {
-        if (connectionName != name) {
-            connectionName = name;
-            emit q->connectionNameChanged();
+    QObject::connect(networkService, &NetworkService::connectedChanged, q, [=]() {
+        scheduleUpdate(ConnectedChange);
+    });
+    QObject::connect(networkService, &NetworkService::autoConnectChanged, q, [=]() {
+        qCDebug(CONNECTIVITY) << "NetworkService::autoConnectChanged"
+                              << "a:" << networkService->autoConnect()
+                              << "c:" << connectingService
+                              << "v:" << valid
+                              << "modem:" << modemManager->defaultDataModem()
+                              << "s:" << networkService->serviceState()
+                              << "available" << networkService->available();
+        if (!autoConnectPending) {
+            scheduleUpdate(AutoConnectChange);
         }
     });
 
-    QObject::connect(connectionContext, &QOfonoConnectionContext::contextPathChanged,
-                     q, [=](const QString &contextPath) {
-        qCDebug(CONNECTIVITY) << "QOfonoConnectionContext contextPathChanged"
-                              << "auto connnect service:" << networkService->autoConnect()
-                              << "pending auto connect:" << autoConnectPending
-                              << "d_ptr autoConnect: " << autoConnect;;
-        if (contextPath.isEmpty()) {
-            networkService->setPath(QString());
-        } else {
-            updateServiceAndTechnology();
-        }
+    QObject::connect(networkService, &NetworkService::pathChanged, q, [=]() {
+        qCDebug(CONNECTIVITY, "MobileDataConnection %s NetworkService::pathChanged %s modem: %s"
+                , qPrintable(q->objectName())
+                , qPrintable(networkService->path())
+                , qPrintable(modemManager->defaultDataModem()));
+        scheduleUpdate(ValidChange | IdentifierChange);
+    });
+
+    QObject::connect(networkService, &NetworkService::savedChanged, q, [=]() {
+        scheduleUpdate(SavedChange);
     });
-    QObject::connect(connectionContext, &QOfonoConnectionContext::validChanged, q, [=]() {
+
+    QObject::connect(&modem->networkRegistration, &QOfonoNetworkRegistration::statusChanged, q, [=]() {
+        scheduleUpdate(RoamingChange);
+    });
+
+    if (!modem->hasDataContext()) {
+        return;
+    }
+
+    QObject::connect(modem->connectionManager.data(), &QOfonoConnectionManager::roamingAllowedChanged, q, [=]() {
+        scheduleUpdate(RoamingAllowedChange);
+    });
+    QObject::connect(modem->connectionManager.data(), &QOfonoConnectionManager::validChanged, q, [=]() {
+        qCDebug(CONNECTIVITY, "QOfonoConnectionManager::validChanged");
+        scheduleUpdate(ValidChange);
+    });
+
+    QObject::connect(modem->connectionContext, &QOfonoConnectionContext::nameChanged, q, [=]() {
+        scheduleUpdate(ConnectionNameChange);
+    });
+    QObject::connect(modem->connectionContext, &QOfonoConnectionContext::validChanged, q, [=]() {
         qCDebug(CONNECTIVITY, "QOfonoConnectionContext::validChanged");
-        updateValid();
+        scheduleUpdate(ValidChange);
     });
 
-    QObject::connect(connectionContext, &QOfonoConnectionContext::reportError, q, &MobileDataConnection::reportError);
+    QObject::connect(modem->connectionContext, &QOfonoConnectionContext::reportError,
+                     q, &MobileDataConnection::reportError);
 }
 
-void MobileDataConnectionPrivate::updateDataContext()
+void MobileDataConnectionPrivate::disconnectModem()
 {
-    // Use modemPath of the SimManager as that contains always the current modem.
-    QString modemPath = simManager.modemPath();
-    createDataContext(modemPath);
-    if (modemPath.isEmpty()) {
-        qCDebug(CONNECTIVITY, "####### Clear data context has data context: %d auto connect: %d %s %s connecting: %d %s\n\n",
-                hasDataContext(), networkService->autoConnect(), qPrintable(q->modemPath()),
-                qPrintable(networkService->path()), connectingService, qPrintable(q->objectName()));
-        inetContextPath = "";
-        connectingService = false;
+    if (!modem) {
+        return;
+    }
 
-        if (hasDataContext()) {
-            connectionContext->setContextPath(QLatin1String(""));
-        }
-    } else if (isDataContextReady(modemPath)) {
-        QStringList contexts = connectionManager->contexts();
-        qCDebug(CONNECTIVITY, "####### Set data context: %s m: %s %s", qPrintable(contexts.join(",")),
-                qPrintable(q->modemPath()), qPrintable(q->objectName()));
-        if (contexts.count() > 0) {
-            inetContextPath = contexts.at(0);
-        } else {
-            inetContextPath = "";
-        }
-        connectionContext->setContextPath(inetContextPath);
-    } else if (hasDataContext() && !connectionManager->powered()) {
-        qCDebug(CONNECTIVITY, "######## Set powered ON");
-        connectionManager->setPowered(true);
+    QObject::disconnect(&modem->simManager, nullptr, q, nullptr);
+    QObject::disconnect(&modem->networkRegistration, nullptr, q, nullptr);
+    QObject::disconnect(modem->networkService, nullptr, q, nullptr);
 
-        if (networkTechnology) {
-            networkTechnology->setPowered(true);
-        }
+    if (modem->hasDataContext()) {
+        QObject::disconnect(modem->connectionManager.data(), nullptr, q, nullptr);
+        QObject::disconnect(modem->connectionContext, nullptr, q, nullptr);
     }
-
 }
 
-bool MobileDataConnectionPrivate::hasDataContext()
+bool MobileDataConnectionPrivate::hasDataContext() const
 {
-    return connectionManager && connectionContext;
+    return modem->hasDataContext();
 }
 
 void MobileDataConnectionPrivate::requestConnect()
 {
-    if (connectingService && valid && !q->modemPath().isEmpty() && networkService->available()) {
+    if (connectingService && valid && !q->modemPath().isEmpty() && modem->networkService->available()) {
         qCDebug(CONNECTIVITY,
                 "\n\n\n\n\n================================= MobileDataConnection requestConnect: %s %s\n\n\n\n\n",
                 qPrintable(q->modemPath()), qPrintable(q->objectName()));
-        networkService->requestConnect();
+        modem->networkService->requestConnect();
         updateStatus();
     }
 }
@@ -384,149 +1054,69 @@ void MobileDataConnectionPrivate::updateDefaultDataSim()
     }
 }
 
+/*
+    Connections following the same modem share its ofono and connman
+    proxies, so the D-Bus traffic scales with the number of modems rather
+    than with the number of instances.
+*/
 MobileDataConnection::MobileDataConnection()
     : d_ptr(new MobileDataConnectionPrivate(this))
 {
-    QObject::connect(&d_ptr->simManager, &QOfonoSimManager::modemPathChanged,
-            this, [=](QString modemPath) {
-        d_ptr->networkRegistration.setModemPath(modemPath);
-
-        if (d_ptr->connectionManager && modemPath != d_ptr->connectionManager->modemPath()) {
-            QObject::disconnect(d_ptr->connectionManager.data(), 0, this, 0);
-            d_ptr->connectionManager.reset();
-            delete d_ptr->connectionContext;
-            d_ptr->connectionContext = nullptr;
-            d_ptr->updateDataContext();
-        }
-
-        emit modemPathChanged();
-        emit slotIndexChanged();
-        qCDebug(CONNECTIVITY, "QOfonoSimManager::modemPathChanged %s index: %d", qPrintable(modemPath), slotIndex());
+    QObject::connect(&d_ptr->staleTimer, &QTimer::timeout, this, [=]() {
+        d_ptr->endStale();
     });
-
-    QObject::connect(&d_ptr->simManager, &QOfonoSimManager::validChanged, this, [=]() {
-        d_ptr->updateNetworkServicePath();
-    });
-    QObject::connect(&d_ptr->simManager, &QOfonoSimManager::presenceChanged, this, [=]() {
-        d_ptr->updateNetworkServicePath();
-    });
-    QObject::connect(&d_ptr->simManager, &QOfonoSimManager::subscriberIdentityChanged, this, [=]() {
-        d_ptr->updateSubscriberIdentity();
-    });
-    QObject::connect(&d_ptr->simManager, &QOfonoSimManager::serviceProviderNameChanged, this, [=]() {
-        d_ptr->updateServiceProviderName();
+    QObject::connect(&d_ptr->snapshotTimer, &QTimer::timeout, this, [=]() {
+        d_ptr->writePendingSnapshot();
     });
 
+    d_ptr->bindModem(QString());
+
     QObject::connect(d_ptr->networkManager.data(), &NetworkManager::technologiesChanged, this, [=]() {
         qCDebug(CONNECTIVITY) << "NetworkManager::technologiesChanged";
-        d_ptr->updateServiceAndTechnology();
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::TechnologyChange);
     });
 
     QObject::connect(d_ptr->networkManager.data(), &NetworkManager::availabilityChanged, this, [=]() {
-        qCDebug(CONNECTIVITY) << "NetworkManager::availabilityChanged auto service:" << d_ptr->networkService->autoConnect()
+        qCDebug(CONNECTIVITY) << "NetworkManager::availabilityChanged auto service:" << d_ptr->modem->networkService->autoConnect()
                               << "pending auto connect:" << d_ptr->autoConnectPending
                               << "d_ptr auto connect: " << d_ptr->autoConnect;
-        d_ptr->updateServiceAndTechnology();
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::TechnologyChange);
     });
 
-    QObject::connect(d_ptr->networkManager.data(), &NetworkManager::cellularServicesChanged, this, [=]() {
-        qCDebug(CONNECTIVITY) << "NetworkManager::servicesChanged auto service:" << d_ptr->networkService->autoConnect()
-                              << "pending auto connect:" << d_ptr->autoConnectPending
-                              << "d_ptr auto connect: " << d_ptr->autoConnect;
-        d_ptr->updateServiceAndTechnology();
-    });
-
-    QObject::connect(d_ptr->networkManager.data(), &NetworkManager::offlineModeChanged,
-            this, &MobileDataConnection::offlineModeChanged);
-
-    QObject::connect(d_ptr->networkService, &NetworkService::errorChanged, this, [=](const QString &error) {
-        if (!error.isEmpty()) {
-            d_ptr->connectingService = false;
-        }
-        emit errorChanged();
-    });
-    QObject::connect(d_ptr->networkService, &NetworkService::serviceStateChanged, this, [=]() {
-        // This and available should be clearly visible in the logs.
-        qCDebug(CONNECTIVITY) << "####################### MobileDataConnection::serviceStateChanged state:"
-                              << d_ptr->networkService->serviceState() << modemPath()
-                              << "available: " << d_ptr->networkService->available(), objectName();
-        d_ptr->updateStatus();
-    });
-
-    QObject::connect(d_ptr->networkService, &NetworkService::validChanged, this, [=]() {
-        qCDebug(CONNECTIVITY, "NetworkService::validChanged mobile data valid old: %d new %d auto connect %d pending auto %d, d_ptr->autoConnect: %d"
-                , d_ptr->valid , d_ptr->isValid()
-                , d_ptr->networkService->autoConnect(), d_ptr->autoConnectPending, d_ptr->autoConnect);
-        d_ptr->updateValid();
-        if (d_ptr->autoConnectPending) {
-            d_ptr->networkService->setAutoConnect(d_ptr->autoConnect);
-            d_ptr->autoConnectPending = false;
-        }
-    });
-
-    QObject::connect(d_ptr->networkService, &NetworkService::availableChanged, this, [=]() {
-        qCDebug(CONNECTIVITY) << "####################### MobileDataConnection::availableChanged state: "
-                              << d_ptr->networkService->serviceState() << modemPath()
-                              << "available: " << d_ptr->networkService->available() << objectName();
-        d_ptr->updateValid();
-        d_ptr->updateStatus();
-    });
-
-    QObject::connect(d_ptr->networkService, &NetworkService::connectedChanged, this, &MobileDataConnection::connectedChanged);
-    QObject::connect(d_ptr->networkService, &NetworkService::autoConnectChanged, this, [=]() {
-        qCDebug(CONNECTIVITY) << "NetworkService::autoConnectChanged"
-                              << "a:" << d_ptr->networkService->autoConnect()
-                              << "c:" << d_ptr->connectingService
-                              << "v:" << d_ptr->valid
-                              << "modem:" << d_ptr->modemManager->defaultDataModem()
-                              << "s:" << d_ptr->networkService->serviceState()
-                              << "available" << d_ptr->networkService->available();
-        if (!d_ptr->autoConnectPending) {
-            emit autoConnectChanged();
-        }
-    });
-
-    QObject::connect(d_ptr->networkService, &NetworkService::pathChanged, this, [=]() {
-        qCDebug(CONNECTIVITY, "MobileDataConnection %s NetworkService::pathChanged %s modem: %s"
-                , qPrintable(objectName())
-                , qPrintable(d_ptr->networkService->path())
-                , qPrintable(d_ptr->modemManager->defaultDataModem()));
-        d_ptr->updateValid();
-        emit identifierChanged();
+    QObject::connect(d_ptr->networkManager.data(), &NetworkManager::offlineModeChanged, this, [=]() {
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::OfflineModeChange);
     });
 
-    QObject::connect(d_ptr->networkService, &NetworkService::savedChanged, this, &MobileDataConnection::savedChanged);
-
-    QObject::connect(&d_ptr->networkRegistration, &QOfonoNetworkRegistration::statusChanged,
-            this, &MobileDataConnection::roamingChanged);
-
     QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::defaultDataSimChanged,
                      this, [=]() {
         qCDebug(CONNECTIVITY, "QOfonoExtModemManager::defaultDataSimChanged: %s %s %s auto connect: %d pending auto: %d, dptr: %d"
-                , qPrintable(d_ptr->servicePathForContext()), qPrintable(modemPath())
+                , qPrintable(d_ptr->modem->networkService->path()), qPrintable(modemPath())
                 , qPrintable(objectName())
-                , d_ptr->networkService->autoConnect()
+                , d_ptr->modem->networkService->autoConnect()
                 , d_ptr->autoConnectPending
                 , d_ptr->autoConnect);
-        d_ptr->updateServiceAndTechnology();
-        emit defaultDataSimChanged();
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::DefaultDataSimChange);
+    });
+    QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::presentSimCountChanged, this, [=]() {
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::PresentSimCountChange);
+    });
+    QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::availableModemsChanged, this, [=]() {
+        d_ptr->scheduleUpdate(MobileDataConnectionPrivate::SlotCountChange
+                              | MobileDataConnectionPrivate::SlotIndexChange);
     });
-    QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::presentSimCountChanged,
-            this, &MobileDataConnection::presentSimCountChanged);
-    QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::availableModemsChanged,
-            this, &MobileDataConnection::slotCountChanged);
     QObject::connect(d_ptr->modemManager.data(), &QOfonoExtModemManager::defaultDataModemChanged,
                      this, [=](QString modemPath) {
         qCDebug(CONNECTIVITY, "QOfonoExtModemManager::defaultDataModemChanged: %s use default: %d %p %s"
                 , qPrintable(modemPath), d_ptr->useDefaultModem, this, qPrintable(objectName()));
         if (d_ptr->useDefaultModem) {
-            d_ptr->simManager.setModemPath(modemPath);
-            d_ptr->updateDataContext();
+            d_ptr->bindModem(modemPath);
         }
     });
 
     /* If we can get network technology initialized the poweredChanged will be connected */
     d_ptr->updateTechnology();
+
+    d_ptr->rememberNotifiedValues();
 }
 
 MobileDataConnection::~MobileDataConnection()
@@ -546,14 +1136,16 @@ bool MobileDataConnection::autoConnect() const
     Q_D(const MobileDataConnection);
     if (d->autoConnectPending)
         return d->autoConnect;
-    return d->networkService->autoConnect();
+    if (d->stale && !d->modem->networkService->isValid())
+        return d->snapshot.value(SnapshotAutoConnect).toBool();
+    return d->modem->networkService->autoConnect();
 }
 
 void MobileDataConnection::setAutoConnect(bool autoConnect)
 {
     Q_D(MobileDataConnection);
-    if (d->networkService->isValid()) {
-        d->networkService->setAutoConnect(autoConnect);
+    if (d->modem->networkService->isValid()) {
+        d->modem->networkService->setAutoConnect(autoConnect);
     } else {
         d->autoConnect = autoConnect;
         d->autoConnectPending = true;
@@ -568,7 +1160,7 @@ void MobileDataConnection::setAutoConnect(bool autoConnect)
 bool MobileDataConnection::connected() const
 {
     Q_D(const MobileDataConnection);
-    return d->networkService->connected();
+    return d->modem->networkService->connected();
 }
 
 MobileDataConnection::Status MobileDataConnection::status() const
@@ -594,8 +1186,7 @@ void MobileDataConnection::setUseDefaultModem(bool useDefaultModem)
         } else {
             modemPath = d->modemPath;
         }
-        d->simManager.setModemPath(modemPath);
-        d->updateDataContext();
+        d->bindModem(modemPath);
         emit useDefaultModemChanged();
     }
 }
@@ -609,7 +1200,7 @@ QString MobileDataConnection::connectionName() const
 QString MobileDataConnection::modemPath() const
 {
     Q_D(const MobileDataConnection);
-    return d->simManager.modemPath();
+    return d->modem->modemPath();
 }
 
 void MobileDataConnection::setModemPath(const QString &modemPath)
@@ -618,10 +1209,8 @@ void MobileDataConnection::setModemPath(const QString &modemPath)
     d->modemPath = modemPath;
 
     if (!d->useDefaultModem) {
-        d->simManager.setModemPath(modemPath);
+        d->bindModem(modemPath);
     }
-
-    d->updateDataContext();
 }
 
 QString MobileDataConnection::defaultDataSim() const
@@ -677,13 +1266,13 @@ QString MobileDataConnection::serviceProviderName() const
 QString MobileDataConnection::identifier() const
 {
     Q_D(const MobileDataConnection);
-    return d->networkService->path();
+    return d->modem->networkService->path();
 }
 
 QString MobileDataConnection::error() const
 {
     Q_D(const MobileDataConnection);
-    return d->networkService->error();
+    return d->modem->networkService->error();
 }
 
 bool MobileDataConnection::offlineMode() const
@@ -695,25 +1284,60 @@ bool MobileDataConnection::offlineMode() const
 bool MobileDataConnection::roamingAllowed() const
 {
     Q_D(const MobileDataConnection);
-    return d->connectionManager && d->connectionManager->roamingAllowed();
+    return d->modem->connectionManager && d->modem->connectionManager->roamingAllowed();
 }
 
 bool MobileDataConnection::roaming() const
 {
     Q_D(const MobileDataConnection);
-    return d->networkRegistration.status() == QLatin1String("roaming");
+    return d->modem->networkRegistration.status() == QLatin1String("roaming");
 }
 
 bool MobileDataConnection::saved() const
 {
     Q_D(const MobileDataConnection);
-    return d->networkService->saved();
+    return d->modem->networkService->saved();
+}
+
+bool MobileDataConnection::useCachedState() const
+{
+    Q_D(const MobileDataConnection);
+    return d->useCachedState;
+}
+
+/*
+    When enabled the last known state of the modem is saved and shown
+    right away on the next start, with stale set until it has been
+    replaced by live data.
+*/
+void MobileDataConnection::setUseCachedState(bool useCachedState)
+{
+    Q_D(MobileDataConnection);
+    if (d->useCachedState == useCachedState) {
+        return;
+    }
+
+    d->useCachedState = useCachedState;
+    if (useCachedState) {
+        d->loadSnapshot();
+        d->saveSnapshot();
+    } else {
+        d->endStale();
+    }
+    emit useCachedStateChanged();
+}
+
+bool MobileDataConnection::isStale() const
+{
+    Q_D(const MobileDataConnection);
+    return d->stale;
 }
 
 void MobileDataConnection::connect()
 {
     Q_D(MobileDataConnection);
     qCDebug(CONNECTIVITY, "Connect: %d valid: %d", autoConnect(), isValid());
+    d->endStale();
     d->connectingService = true;
     d->requestConnect();
     d->updateStatus();
@@ -722,7 +1346,8 @@ void MobileDataConnection::connect()
 void MobileDataConnection::disconnect()
 {
     Q_D(MobileDataConnection);
-    d->networkService->requestDisconnect();
+    d->endStale();
+    d->modem->networkService->requestDisconnect();
     d->connectingService = false;
     d->updateStatus();
 }
@@ -735,7 +1360,7 @@ void MobileDataConnectionPrivate::techPoweredChanged(bool techPowered)
         return;
     }
 
-    powered = connectionManager->powered();
+    powered = modem->connectionManager->powered();
 
     qCDebug(CONNECTIVITY, "NetworkTechnology poweredChanged: internal powered %d tech powered %d ", powered, techPowered);
 
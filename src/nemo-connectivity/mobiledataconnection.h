@@ -76,6 +76,9 @@ class NEMO_CONNECTIVITY_EXPORT MobileDataConnection : public QObject
 
     Q_PROPERTY(bool saved READ saved NOTIFY savedChanged)
 
+    Q_PROPERTY(bool useCachedState READ useCachedState WRITE setUseCachedState NOTIFY useCachedStateChanged)
+    Q_PROPERTY(bool stale READ isStale NOTIFY staleChanged)
+
 public:
     MobileDataConnection();
     ~MobileDataConnection();
@@ -128,6 +131,11 @@ public:
 
     bool saved() const;
 
+    bool useCachedState() const;
+    void setUseCachedState(bool useCachedState);
+
+    bool isStale() const;
+
     Q_INVOKABLE void connect();
     Q_INVOKABLE void disconnect();
 
@@ -161,12 +169,16 @@ Q_SIGNALS:
 
     void savedChanged();
 
+    void useCachedStateChanged();
+    void staleChanged();
+
     void reportError(const QString &errorString);
 
 private:
     MobileDataConnectionPrivate *d_ptr;
     Q_DISABLE_COPY(MobileDataConnection)
     Q_DECLARE_PRIVATE(MobileDataConnection)
+    friend class MobileDataConnectionModelPrivate;
 };
 
 }
@@ -32,7 +32,10 @@
 #ifndef NEMO_MOBILEDATACONNECTION_P_H
 #define NEMO_MOBILEDATACONNECTION_P_H
 
+#include <QHash>
 #include <QSharedPointer>
+#include <QTimer>
+#include <QVariantMap>
 
 #include <qofonoextmodemmanager.h>
 #include <qofonoconnectionmanager.h>
@@ -49,9 +52,103 @@ namespace Nemo {
 
 class MobileDataConnection;
 
+/*
+    Connman's cellular services keyed by subscriber identity and context
+    name, kept up to date from service additions and removals.
+*/
+class CellularServiceIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static QSharedPointer<CellularServiceIndex> sharedInstance();
+
+    QString servicePath(const QString &subscriberIdentity, const QString &context) const;
+
+Q_SIGNALS:
+    void servicesChanged(const QString &subscriberIdentity);
+
+private:
+    CellularServiceIndex();
+
+    void rebuild();
+    bool addService(const QString &servicePath, QString *subscriberIdentity);
+    bool removeService(const QString &servicePath, QString *subscriberIdentity);
+
+    QSharedPointer<NetworkManager> m_networkManager;
+    QHash<QString, QHash<QString, QString> > m_services;
+};
+
+/*
+    The ofono and connman proxies of one modem, shared by every
+    MobileDataConnection currently following that modem path.
+*/
+class MobileDataModem : public QObject
+{
+    Q_OBJECT
+public:
+    ~MobileDataModem();
+
+    static QSharedPointer<MobileDataModem> instance(const QString &modemPath);
+
+    QString modemPath() const;
+
+    bool isSimManagerValid() const;
+    bool isDataContextReady() const;
+    bool hasDataContext() const;
+
+    QString servicePathForContext() const;
+
+    void updateDataContext();
+    void updateServicePath();
+
+    QString inetContextPath;
+    QString contextName;
+
+    QSharedPointer<QOfonoExtModemManager> modemManager;
+    QSharedPointer<NetworkManager> networkManager;
+    QSharedPointer<CellularServiceIndex> serviceIndex;
+
+    QOfonoSimManager simManager;
+    QOfonoNetworkRegistration networkRegistration;
+    NetworkService *networkService;
+
+    QSharedPointer<QOfonoConnectionManager> connectionManager;
+    QOfonoConnectionContext *connectionContext;
+
+private:
+    explicit MobileDataModem(const QString &modemPath);
+};
+
 class MobileDataConnectionPrivate
 {
 public:
+    enum Change {
+        SimChange = 0x00001,
+        SubscriberIdentityChange = 0x00002,
+        ServiceProviderNameChange = 0x00004,
+        ConnectionNameChange = 0x00008,
+        TechnologyChange = 0x00010,
+        ValidChange = 0x00020,
+        StatusChange = 0x00040,
+        ModemPathChange = 0x00080,
+        SlotIndexChange = 0x00100,
+        SlotCountChange = 0x00200,
+        IdentifierChange = 0x00400,
+        ConnectedChange = 0x00800,
+        AutoConnectChange = 0x01000,
+        ErrorChange = 0x02000,
+        SavedChange = 0x04000,
+        RoamingChange = 0x08000,
+        RoamingAllowedChange = 0x10000,
+        DefaultDataSimChange = 0x20000,
+        PresentSimCountChange = 0x40000,
+        OfflineModeChange = 0x80000,
+        StaleChange = 0x100000,
+
+        // Held back while properties show the cached snapshot.
+        SnapshotChanges = ServiceProviderNameChange | ConnectionNameChange | StatusChange
+    };
+
     MobileDataConnectionPrivate(Nemo::MobileDataConnection *q);
     ~MobileDataConnectionPrivate();
 
@@ -59,21 +156,29 @@ public:
     void updateValid();
     bool isSimManagerValid() const;
 
+    void scheduleUpdate(int changes);
+    void runUpdate();
+    void rememberNotifiedValues();
+
     void updateStatus();
-    void updateNetworkServicePath();
     void updateSubscriberIdentity();
     void updateServiceProviderName();
-    void updateServiceAndTechnology();
+    void updateConnectionName();
     void updateTechnology();
     void techPoweredChanged(bool techPowered);
 
-    QString servicePathForContext();
+    QVariantMap currentSnapshot() const;
+    bool snapshotMismatch() const;
+    void loadSnapshot();
+    void saveSnapshot();
+    void writePendingSnapshot();
+    void endStale();
 
-    bool isDataContextReady(const QString &modemPath) const;
+    void bindModem(const QString &modemPath);
+    void connectModem();
+    void disconnectModem();
 
-    void createDataContext(const QString &modemPath);
-    void updateDataContext();
-    bool hasDataContext();
+    bool hasDataContext() const;
     void updateDefaultDataSim();
 
     void requestConnect();
@@ -89,7 +194,35 @@ public:
 
     bool useDefaultModem;
 
-    QString inetContextPath;
+    int pendingChanges;
+    bool updateScheduled;
+
+    bool useCachedState;
+    bool stale;
+    int heldChanges;
+    QVariantMap snapshot;
+    QString snapshotKey;
+    QString snapshotModemPath;
+    bool snapshotPending;
+    QTimer snapshotTimer;
+    QTimer staleTimer;
+
+    // Last values notified by runUpdate().
+    QString notifiedModemPath;
+    int notifiedSlotIndex;
+    int notifiedSlotCount;
+    QString notifiedIdentifier;
+    bool notifiedConnected;
+    bool notifiedAutoConnect;
+    QString notifiedError;
+    bool notifiedSaved;
+    bool notifiedRoaming;
+    bool notifiedRoamingAllowed;
+    QString notifiedDefaultDataSim;
+    int notifiedPresentSimCount;
+    bool notifiedOfflineMode;
+    bool notifiedStale;
+
     QString connectionName;
     QString modemPath;
     QString subscriberIdentity;
@@ -98,16 +231,10 @@ public:
     MobileDataConnection *q;
 
     QSharedPointer<QOfonoExtModemManager> modemManager;
-
-    QOfonoSimManager simManager;
-
     QSharedPointer<NetworkManager> networkManager;
-    NetworkService *networkService;
     NetworkTechnology *networkTechnology;
-    QOfonoNetworkRegistration networkRegistration;
 
-    QSharedPointer<QOfonoConnectionManager> connectionManager;
-    QOfonoConnectionContext *connectionContext;
+    QSharedPointer<MobileDataModem> modem;
 };
 
 }
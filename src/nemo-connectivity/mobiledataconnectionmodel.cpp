@@ -0,0 +1,319 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "mobiledataconnectionmodel.h"
+#include "mobiledataconnection_p.h"
+
+#include <qofonoextmodemmanager.h>
+
+namespace Nemo {
+
+class MobileDataConnectionModelPrivate
+{
+public:
+    MobileDataConnectionModelPrivate(MobileDataConnectionModel *q);
+
+    MobileDataConnection *createConnection(const QString &modemPath);
+    void scheduleRows(int changes, int first = 0);
+    void rowChanged(MobileDataConnection *connection, const QVector<int> &roles);
+
+    MobileDataConnectionModel *q;
+    QSharedPointer<QOfonoExtModemManager> modemManager;
+    QStringList modemPaths;
+    QList<MobileDataConnection *> connections;
+};
+
+MobileDataConnectionModelPrivate::MobileDataConnectionModelPrivate(MobileDataConnectionModel *q)
+    : q(q)
+    , modemManager(QOfonoExtModemManager::instance())
+{
+}
+
+MobileDataConnection *MobileDataConnectionModelPrivate::createConnection(const QString &modemPath)
+{
+    MobileDataConnection *connection = new MobileDataConnection;
+    connection->setParent(q);
+    connection->setObjectName(modemPath);
+    connection->setModemPath(modemPath);
+
+    // The model already follows these for every row and passes them on
+    // in scheduleRows(), so rows don't listen to them a second time.
+    QObject::disconnect(modemManager.data(), &QOfonoExtModemManager::availableModemsChanged, connection, nullptr);
+    QObject::disconnect(modemManager.data(), &QOfonoExtModemManager::presentSimCountChanged, connection, nullptr);
+    QObject::disconnect(modemManager.data(), &QOfonoExtModemManager::defaultDataSimChanged, connection, nullptr);
+
+    auto notify = [=](int role) {
+        return [=]() {
+            rowChanged(connection, QVector<int>() << role);
+        };
+    };
+
+    QObject::connect(connection, &MobileDataConnection::validChanged,
+                     q, notify(MobileDataConnectionModel::ValidRole));
+    QObject::connect(connection, &MobileDataConnection::statusChanged,
+                     q, notify(MobileDataConnectionModel::StatusRole));
+    QObject::connect(connection, &MobileDataConnection::connectedChanged,
+                     q, notify(MobileDataConnectionModel::ConnectedRole));
+    QObject::connect(connection, &MobileDataConnection::autoConnectChanged,
+                     q, notify(MobileDataConnectionModel::AutoConnectRole));
+    QObject::connect(connection, &MobileDataConnection::connectionNameChanged,
+                     q, notify(MobileDataConnectionModel::ConnectionNameRole));
+    QObject::connect(connection, &MobileDataConnection::serviceProviderNameChanged,
+                     q, notify(MobileDataConnectionModel::ServiceProviderNameRole));
+    QObject::connect(connection, &MobileDataConnection::identifierChanged,
+                     q, notify(MobileDataConnectionModel::IdentifierRole));
+    QObject::connect(connection, &MobileDataConnection::roamingChanged,
+                     q, notify(MobileDataConnectionModel::RoamingRole));
+    QObject::connect(connection, &MobileDataConnection::roamingAllowedChanged,
+                     q, notify(MobileDataConnectionModel::RoamingAllowedRole));
+    QObject::connect(connection, &MobileDataConnection::subscriberIdentityChanged, q, [=]() {
+        rowChanged(connection, QVector<int>() << MobileDataConnectionModel::SubscriberIdentityRole
+                                              << MobileDataConnectionModel::DefaultDataSimRole);
+    });
+
+    return connection;
+}
+
+void MobileDataConnectionModelPrivate::scheduleRows(int changes, int first)
+{
+    for (int i = first; i < connections.count(); ++i) {
+        connections.at(i)->d_ptr->scheduleUpdate(changes);
+    }
+}
+
+void MobileDataConnectionModelPrivate::rowChanged(MobileDataConnection *connection, const QVector<int> &roles)
+{
+    int row = connections.indexOf(connection);
+    if (row >= 0) {
+        QModelIndex index = q->index(row);
+        emit q->dataChanged(index, index, roles);
+    }
+}
+
+/*
+    Lists every modem known to ofono, in slot order, as a row. A row is
+    backed by a MobileDataConnection bound to that modem, which get()
+    returns for connecting or changing autoConnect. Like any connection
+    it uses the ofono and connman proxies shared per modem, so a model
+    next to standalone connections for the same slots adds no D-Bus
+    proxies of its own. The modem manager is followed once by the model,
+    which passes slot and SIM changes on to the rows. Rows are added and
+    removed in place as modems come and go, so delegates for unchanged
+    slots are kept, and the slot index is the row rather than a lookup in
+    the modem list.
+*/
+MobileDataConnectionModel::MobileDataConnectionModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , d_ptr(new MobileDataConnectionModelPrivate(this))
+{
+    Q_D(MobileDataConnectionModel);
+
+    connect(d->modemManager.data(), &QOfonoExtModemManager::availableModemsChanged,
+            this, &MobileDataConnectionModel::updateModems);
+    connect(d->modemManager.data(), &QOfonoExtModemManager::presentSimCountChanged, this, [=]() {
+        d->scheduleRows(MobileDataConnectionPrivate::PresentSimCountChange);
+        emit presentSimCountChanged();
+    });
+    connect(d->modemManager.data(), &QOfonoExtModemManager::defaultDataSimChanged, this, [=]() {
+        d->scheduleRows(MobileDataConnectionPrivate::DefaultDataSimChange);
+        if (!d->connections.isEmpty()) {
+            emit dataChanged(index(0), index(d->connections.count() - 1), QVector<int>() << DefaultDataSimRole);
+        }
+        emit defaultDataSimChanged();
+    });
+
+    updateModems();
+}
+
+MobileDataConnectionModel::~MobileDataConnectionModel()
+{
+    qDeleteAll(d_ptr->connections);
+    delete d_ptr;
+    d_ptr = nullptr;
+}
+
+QHash<int, QByteArray> MobileDataConnectionModel::roleNames() const
+{
+    static const QHash<int, QByteArray> roles = {
+        { ConnectionRole, "connection" },
+        { ModemPathRole, "modemPath" },
+        { SlotIndexRole, "slotIndex" },
+        { ValidRole, "valid" },
+        { StatusRole, "status" },
+        { ConnectedRole, "connected" },
+        { AutoConnectRole, "autoConnect" },
+        { ConnectionNameRole, "connectionName" },
+        { SubscriberIdentityRole, "subscriberIdentity" },
+        { ServiceProviderNameRole, "serviceProviderName" },
+        { IdentifierRole, "identifier" },
+        { RoamingRole, "roaming" },
+        { RoamingAllowedRole, "roamingAllowed" },
+        { DefaultDataSimRole, "defaultDataSim" }
+    };
+    return roles;
+}
+
+int MobileDataConnectionModel::rowCount(const QModelIndex &parent) const
+{
+    Q_D(const MobileDataConnectionModel);
+    return parent.isValid() ? 0 : d->connections.count();
+}
+
+QVariant MobileDataConnectionModel::data(const QModelIndex &index, int role) const
+{
+    Q_D(const MobileDataConnectionModel);
+    if (!index.isValid() || index.row() >= d->connections.count()) {
+        return QVariant();
+    }
+
+    MobileDataConnection *connection = d->connections.at(index.row());
+    switch (role) {
+    case ConnectionRole:
+        return QVariant::fromValue<QObject *>(connection);
+    case ModemPathRole:
+        return d->modemPaths.at(index.row());
+    case SlotIndexRole:
+        return index.row();
+    case ValidRole:
+        return connection->isValid();
+    case StatusRole:
+        return connection->status();
+    case ConnectedRole:
+        return connection->connected();
+    case AutoConnectRole:
+        return connection->autoConnect();
+    case ConnectionNameRole:
+        return connection->connectionName();
+    case SubscriberIdentityRole:
+        return connection->subscriberIdentity();
+    case ServiceProviderNameRole:
+        return connection->serviceProviderName();
+    case IdentifierRole:
+        return connection->identifier();
+    case RoamingRole:
+        return connection->roaming();
+    case RoamingAllowedRole:
+        return connection->roamingAllowed();
+    case DefaultDataSimRole:
+        return !connection->subscriberIdentity().isEmpty()
+                && connection->subscriberIdentity() == d->modemManager->defaultDataSim();
+    default:
+        return QVariant();
+    }
+}
+
+QString MobileDataConnectionModel::defaultDataSim() const
+{
+    Q_D(const MobileDataConnectionModel);
+    return d->modemManager->defaultDataSim();
+}
+
+void MobileDataConnectionModel::setDefaultDataSim(const QString &subscriberIdentity)
+{
+    Q_D(MobileDataConnectionModel);
+    d->modemManager->setDefaultDataSim(subscriberIdentity);
+}
+
+int MobileDataConnectionModel::presentSimCount() const
+{
+    Q_D(const MobileDataConnectionModel);
+    return d->modemManager->presentSimCount();
+}
+
+MobileDataConnection *MobileDataConnectionModel::get(int index) const
+{
+    Q_D(const MobileDataConnectionModel);
+    return d->connections.value(index);
+}
+
+int MobileDataConnectionModel::indexOf(const QString &modemPath) const
+{
+    Q_D(const MobileDataConnectionModel);
+    return d->modemPaths.indexOf(modemPath);
+}
+
+/*
+    Brings the rows in line with the modem manager's list: rows of modems
+    that went away are removed, surviving rows are moved into slot order
+    and new modems are inserted where they appear. Slot indices are
+    refreshed for the rows after the first one that changed.
+*/
+void MobileDataConnectionModel::updateModems()
+{
+    Q_D(MobileDataConnectionModel);
+    const QStringList modems = d->modemManager->availableModems();
+    const int oldCount = d->connections.count();
+    int firstChanged = -1;
+
+    for (int i = d->modemPaths.count() - 1; i >= 0; --i) {
+        if (!modems.contains(d->modemPaths.at(i))) {
+            beginRemoveRows(QModelIndex(), i, i);
+            d->modemPaths.removeAt(i);
+            delete d->connections.takeAt(i);
+            endRemoveRows();
+            firstChanged = i;
+        }
+    }
+
+    for (int i = 0; i < modems.count(); ++i) {
+        const QString &modemPath = modems.at(i);
+        if (i < d->modemPaths.count() && d->modemPaths.at(i) == modemPath) {
+            continue;
+        }
+
+        if (firstChanged < 0 || i < firstChanged) {
+            firstChanged = i;
+        }
+
+        int from = d->modemPaths.indexOf(modemPath, i);
+        if (from > i) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+            d->modemPaths.move(from, i);
+            d->connections.move(from, i);
+            endMoveRows();
+        } else {
+            beginInsertRows(QModelIndex(), i, i);
+            d->modemPaths.insert(i, modemPath);
+            d->connections.insert(i, d->createConnection(modemPath));
+            endInsertRows();
+        }
+    }
+
+    if (firstChanged >= 0 && firstChanged < d->connections.count()) {
+        d->scheduleRows(MobileDataConnectionPrivate::SlotIndexChange, firstChanged);
+        emit dataChanged(index(firstChanged), index(d->connections.count() - 1),
+                         QVector<int>() << SlotIndexRole);
+    }
+
+    if (oldCount != d->connections.count()) {
+        d->scheduleRows(MobileDataConnectionPrivate::SlotCountChange);
+        emit countChanged();
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_MOBILEDATACONNECTIONMODEL_H
+#define NEMO_MOBILEDATACONNECTIONMODEL_H
+
+#include <QAbstractListModel>
+
+#include <nemo-connectivity/global.h>
+#include <nemo-connectivity/mobiledataconnection.h>
+
+namespace Nemo {
+
+class MobileDataConnectionModelPrivate;
+
+class NEMO_CONNECTIVITY_EXPORT MobileDataConnectionModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(QString defaultDataSim READ defaultDataSim WRITE setDefaultDataSim NOTIFY defaultDataSimChanged)
+    Q_PROPERTY(int presentSimCount READ presentSimCount NOTIFY presentSimCountChanged)
+
+public:
+    explicit MobileDataConnectionModel(QObject *parent = nullptr);
+    ~MobileDataConnectionModel();
+
+    enum Roles {
+        ConnectionRole = Qt::UserRole + 1,
+        ModemPathRole,
+        SlotIndexRole,
+        ValidRole,
+        StatusRole,
+        ConnectedRole,
+        AutoConnectRole,
+        ConnectionNameRole,
+        SubscriberIdentityRole,
+        ServiceProviderNameRole,
+        IdentifierRole,
+        RoamingRole,
+        RoamingAllowedRole,
+        DefaultDataSimRole
+    };
+    Q_ENUM(Roles)
+
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    QString defaultDataSim() const;
+    void setDefaultDataSim(const QString &subscriberIdentity);
+
+    int presentSimCount() const;
+
+    Q_INVOKABLE Nemo::MobileDataConnection *get(int index) const;
+    Q_INVOKABLE int indexOf(const QString &modemPath) const;
+
+Q_SIGNALS:
+    void countChanged();
+    void defaultDataSimChanged();
+    void presentSimCountChanged();
+
+private Q_SLOTS:
+    void updateModems();
+
+private:
+    MobileDataConnectionModelPrivate *d_ptr;
+    Q_DISABLE_COPY(MobileDataConnectionModel)
+    Q_DECLARE_PRIVATE(MobileDataConnectionModel)
+};
+
+}
+
+#endif
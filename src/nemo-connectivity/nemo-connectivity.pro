@@ -8,7 +8,7 @@ CONFIG += \
         create_prl \
         no_install_prl
 
-QT = dbus network qml xmlpatterns
+QT = dbus gui network qml xmlpatterns
 
 INCLUDEPATH += ..
 
@@ -21,16 +21,32 @@ PKGCONFIG += \
 
 SOURCES += \
         connectionhelper.cpp \
+        connectivitybackend.cpp \
+        connectivitypolicy.cpp \
+        connectivityprobe.cpp \
+        latencyhistogram.cpp \
+        linkwatcher.cpp \
+        linkquality.cpp \
         mobiledataconnection.cpp \
+        mobiledataconnectionmodel.cpp \
+        networkrequirement.cpp \
         settingsvpnmodel.cpp
 
 PUBLIC_HEADERS += \
         connectionhelper.h \
+        connectivitypolicy.h \
+        latencyhistogram.h \
+        linkquality.h \
         mobiledataconnection.h \
+        mobiledataconnectionmodel.h \
+        networkrequirement.h \
         settingsvpnmodel.h \
         global.h
 
 HEADERS += $$PUBLIC_HEADERS \
+    connectivitybackend_p.h \
+    connectivityprobe_p.h \
+    linkwatcher_p.h \
     mobiledataconnection_p.h \
 
 public_headers.files = $$PUBLIC_HEADERS
@@ -44,7 +60,7 @@ QMAKE_PKGCONFIG_LIBDIR = $$target.path
 QMAKE_PKGCONFIG_INCDIR = $$public_headers.path
 QMAKE_PKGCONFIG_DESTDIR = pkgconfig
 QMAKE_PKGCONFIG_VERSION = $$VERSION
-QMAKE_PKGCONFIG_REQUIRES = Qt5Core Qt5DBus connman-qt$${QT_MAJOR_VERSION}
+QMAKE_PKGCONFIG_REQUIRES = Qt5Core Qt5DBus Qt5Network connman-qt$${QT_MAJOR_VERSION}
 
 INSTALLS += \
         public_headers \
@@ -0,0 +1,208 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "networkrequirement.h"
+#include "connectivitybackend_p.h"
+
+namespace Nemo {
+
+class NetworkRequirementPrivate
+{
+public:
+    NetworkRequirementPrivate();
+
+    bool unmetered;
+    bool notRoaming;
+    int minimumBandwidth;
+    int maximumRtt;
+    bool vpn;
+    bool satisfied;
+    QSharedPointer<ConnectivityBackend> backend;
+};
+
+NetworkRequirementPrivate::NetworkRequirementPrivate()
+    : unmetered(false)
+    , notRoaming(false)
+    , minimumBandwidth(0)
+    , maximumRtt(0)
+    , vpn(false)
+    , satisfied(false)
+    , backend(ConnectivityBackend::sharedInstance())
+{
+}
+
+/*
+    What a network has to offer for some piece of work, e.g. a large
+    transfer that should wait for an unmetered network. The requirement is
+    satisfied while the default route is online and meets every condition
+    set; available() and lost() tell when that changes. Without conditions
+    it follows plain online state.
+
+    All requirements are evaluated against the same view of the network,
+    computed once from connman's service properties and the quality
+    measured by the canary requests and traffic through the shared network
+    access manager, and checked again only when that view changes.
+*/
+NetworkRequirement::NetworkRequirement(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new NetworkRequirementPrivate)
+{
+    Q_D(NetworkRequirement);
+    connect(d->backend.data(), &ConnectivityBackend::capabilitiesChanged,
+            this, &NetworkRequirement::evaluate);
+    d->satisfied = d->backend->capabilities().satisfies(*this);
+}
+
+NetworkRequirement::~NetworkRequirement()
+{
+    delete d_ptr;
+    d_ptr = nullptr;
+}
+
+/*
+    Excludes networks charged by volume, i.e. cellular ones.
+*/
+bool NetworkRequirement::unmetered() const
+{
+    Q_D(const NetworkRequirement);
+    return d->unmetered;
+}
+
+void NetworkRequirement::setUnmetered(bool unmetered)
+{
+    Q_D(NetworkRequirement);
+    if (d->unmetered != unmetered) {
+        d->unmetered = unmetered;
+        emit unmeteredChanged();
+        evaluate();
+    }
+}
+
+/*
+    Excludes cellular networks while roaming.
+*/
+bool NetworkRequirement::notRoaming() const
+{
+    Q_D(const NetworkRequirement);
+    return d->notRoaming;
+}
+
+void NetworkRequirement::setNotRoaming(bool notRoaming)
+{
+    Q_D(NetworkRequirement);
+    if (d->notRoaming != notRoaming) {
+        d->notRoaming = notRoaming;
+        emit notRoamingChanged();
+        evaluate();
+    }
+}
+
+/*
+    Estimated downstream bandwidth needed, in kbit/s. The estimate comes
+    from large downloads through the shared network access manager; until
+    there is one on the current route, this condition is not held against
+    it. Zero, the default, accepts any bandwidth.
+*/
+int NetworkRequirement::minimumBandwidth() const
+{
+    Q_D(const NetworkRequirement);
+    return d->minimumBandwidth;
+}
+
+void NetworkRequirement::setMinimumBandwidth(int bandwidth)
+{
+    Q_D(NetworkRequirement);
+    if (d->minimumBandwidth != bandwidth) {
+        d->minimumBandwidth = bandwidth;
+        emit minimumBandwidthChanged();
+        evaluate();
+    }
+}
+
+/*
+    Largest acceptable smoothed round-trip time in milliseconds, as
+    measured by canary requests on the current route. Like the bandwidth,
+    only applied once measured. Zero, the default, accepts any.
+*/
+int NetworkRequirement::maximumRtt() const
+{
+    Q_D(const NetworkRequirement);
+    return d->maximumRtt;
+}
+
+void NetworkRequirement::setMaximumRtt(int rtt)
+{
+    Q_D(NetworkRequirement);
+    if (d->maximumRtt != rtt) {
+        d->maximumRtt = rtt;
+        emit maximumRttChanged();
+        evaluate();
+    }
+}
+
+/*
+    Requires a connected VPN.
+*/
+bool NetworkRequirement::vpn() const
+{
+    Q_D(const NetworkRequirement);
+    return d->vpn;
+}
+
+void NetworkRequirement::setVpn(bool vpn)
+{
+    Q_D(NetworkRequirement);
+    if (d->vpn != vpn) {
+        d->vpn = vpn;
+        emit vpnChanged();
+        evaluate();
+    }
+}
+
+bool NetworkRequirement::satisfied() const
+{
+    Q_D(const NetworkRequirement);
+    return d->satisfied;
+}
+
+void NetworkRequirement::evaluate()
+{
+    Q_D(NetworkRequirement);
+    const bool satisfied = d->backend->capabilities().satisfies(*this);
+    if (d->satisfied != satisfied) {
+        d->satisfied = satisfied;
+        emit satisfiedChanged();
+        if (satisfied) {
+            emit available();
+        } else {
+            emit lost();
+        }
+    }
+}
+
+}
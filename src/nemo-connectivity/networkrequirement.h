@@ -0,0 +1,92 @@
+/* Copyright (c) 2026 Jolla Ltd.
+ *
+ * License: BSD
+ *
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef NEMO_NETWORKREQUIREMENT_H
+#define NEMO_NETWORKREQUIREMENT_H
+
+#include <QObject>
+
+#include <nemo-connectivity/global.h>
+
+namespace Nemo {
+
+class NetworkRequirementPrivate;
+
+class NEMO_CONNECTIVITY_EXPORT NetworkRequirement : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool unmetered READ unmetered WRITE setUnmetered NOTIFY unmeteredChanged)
+    Q_PROPERTY(bool notRoaming READ notRoaming WRITE setNotRoaming NOTIFY notRoamingChanged)
+    Q_PROPERTY(int minimumBandwidth READ minimumBandwidth WRITE setMinimumBandwidth NOTIFY minimumBandwidthChanged)
+    Q_PROPERTY(int maximumRtt READ maximumRtt WRITE setMaximumRtt NOTIFY maximumRttChanged)
+    Q_PROPERTY(bool vpn READ vpn WRITE setVpn NOTIFY vpnChanged)
+    Q_PROPERTY(bool satisfied READ satisfied NOTIFY satisfiedChanged)
+
+public:
+    explicit NetworkRequirement(QObject *parent = nullptr);
+    ~NetworkRequirement();
+
+    bool unmetered() const;
+    void setUnmetered(bool unmetered);
+
+    bool notRoaming() const;
+    void setNotRoaming(bool notRoaming);
+
+    int minimumBandwidth() const;
+    void setMinimumBandwidth(int bandwidth);
+
+    int maximumRtt() const;
+    void setMaximumRtt(int rtt);
+
+    bool vpn() const;
+    void setVpn(bool vpn);
+
+    bool satisfied() const;
+
+Q_SIGNALS:
+    void unmeteredChanged();
+    void notRoamingChanged();
+    void minimumBandwidthChanged();
+    void maximumRttChanged();
+    void vpnChanged();
+    void satisfiedChanged();
+    void available();
+    void lost();
+
+private Q_SLOTS:
+    void evaluate();
+
+private:
+    NetworkRequirementPrivate *d_ptr;
+    Q_DISABLE_COPY(NetworkRequirement)
+    Q_DECLARE_PRIVATE(NetworkRequirement)
+};
+
+}
+
+#endif
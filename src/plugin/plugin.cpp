@@ -35,7 +35,10 @@
 #include <QQmlExtensionPlugin>
 
 #include "mobiledataconnection.h"
+#include "mobiledataconnectionmodel.h"
 #include "connectionhelper.h"
+#include "connectivitypolicy.h"
+#include "networkrequirement.h"
 #include "settingsvpnmodel.h"
 
 template<class T>
@@ -62,7 +65,10 @@ public:
     {
         Q_ASSERT(uri == QLatin1String("Nemo.Connectivity"));
         qmlRegisterType<Nemo::ConnectionHelper>(uri, 1, 0, "ConnectionHelper");
+        qmlRegisterType<Nemo::ConnectivityPolicy>(uri, 1, 0, "ConnectivityPolicy");
         qmlRegisterType<Nemo::MobileDataConnection>(uri, 1, 0, "MobileDataConnection");
+        qmlRegisterType<Nemo::MobileDataConnectionModel>(uri, 1, 0, "MobileDataConnectionModel");
+        qmlRegisterType<Nemo::NetworkRequirement>(uri, 1, 0, "NetworkRequirement");
         qmlRegisterSingletonType<SettingsVpnModel>(uri, 1, 0, "SettingsVpnModel", api_factory<SettingsVpnModel>);
     }
 };